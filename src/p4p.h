@@ -4,6 +4,8 @@
 #include <sstream>
 #include <algorithm>
 #include <stdexcept>
+#include <list>
+#include <map>
 
 #ifdef READONLY
 // don't want def from shareLib.h
@@ -95,6 +97,79 @@ struct PyRef {
     CollectReturn collect() { return CollectReturn(*this); }
 };
 
+/* Map whose entries have a total cost (by default, one each) kept within 'limit'
+ * by evicting the least recently used.
+ * Not thread safe.  Values holding a PyRef need the GIL for any call which may evict.
+ */
+template<typename K, typename V>
+struct LRUCache {
+    struct Entry {
+        K key;
+        V value;
+        size_t cost;
+    };
+    typedef std::list<Entry> entries_t; // most recently used first
+    typedef std::map<K, typename entries_t::iterator> index_t;
+
+    entries_t entries;
+    index_t index;
+    size_t limit, total, nEvict;
+
+    explicit LRUCache(size_t limit) :limit(limit), total(0u), nEvict(0u) {}
+
+    size_t size() const { return index.size(); }
+
+    // the entry for 'key', now the most recently used, or NULL
+    V* find(const K& key) {
+        typename index_t::iterator it(index.find(key));
+        if(it==index.end())
+            return 0;
+        entries.splice(entries.begin(), entries, it->second);
+        return &it->second->value;
+    }
+
+    // add, or replace, an entry.  Evicts others as needed, but never the new entry.
+    V& insert(const K& key, const V& value, size_t cost = 1u) {
+        erase(key);
+        Entry ent = {key, value, cost};
+        entries.push_front(ent);
+        index[key] = entries.begin();
+        total += cost;
+        trim();
+        return entries.front().value;
+    }
+
+    void erase(const K& key) {
+        typename index_t::iterator it(index.find(key));
+        if(it==index.end())
+            return;
+        total -= it->second->cost;
+        entries.erase(it->second);
+        index.erase(it);
+    }
+
+    void setLimit(size_t l) {
+        limit = l;
+        trim();
+    }
+
+    void clear() {
+        index.clear();
+        entries.clear();
+        total = 0u;
+    }
+
+    void trim() {
+        while(total > limit && entries.size() > 1u) {
+            Entry& ent = entries.back();
+            total -= ent.cost;
+            index.erase(ent.key);
+            entries.pop_back();
+            nEvict++;
+        }
+    }
+};
+
 struct PyString
 {
     PyObject *base;
@@ -196,13 +271,38 @@ typedef epics::pvData::shared_vector<const void> array_type;
 extern PyTypeObject* P4PArray_type;
 PyObject* P4PArray_make(const array_type& v);
 const array_type& P4PArray_extract(PyObject* o);
+// Allocate storage for an array of 'count' elements from the buffer pool
+epics::pvData::shared_vector<void> P4PArray_alloc(epics::pvData::ScalarType etype, size_t count);
+// Convert 'count' elements between numeric (non-string) scalar types.
+// 'dest' must have room for 'count' elements of 'dtype'.
+// Floating point to integer sets ValueError, and throws, if any element is NaN or out of range.
+// Call with GIL held.
+void P4PArray_convert(epics::pvData::ScalarType dtype, void *dest,
+                      epics::pvData::ScalarType stype, const void *src,
+                      size_t count);
 
 extern PyTypeObject* P4PValue_type;
 epics::pvData::PVStructure::shared_pointer P4PValue_unwrap(PyObject *);
 std::tr1::shared_ptr<epics::pvData::BitSet> P4PValue_unwrap_bitset(PyObject *);
+// 'holder' is kept alive by the Value, and any sub-structure Values
 PyObject *P4PValue_wrap(PyTypeObject *type,
                         const epics::pvData::PVStructure::shared_pointer&,
-                        const epics::pvData::BitSet::shared_pointer& = epics::pvData::BitSet::shared_pointer());
+                        const epics::pvData::BitSet::shared_pointer& = epics::pvData::BitSet::shared_pointer(),
+                        const std::tr1::shared_ptr<void>& holder = std::tr1::shared_ptr<void>());
+// Attach the overrun BitSet of a monitor update
+void P4PValue_set_overrun(PyObject *value, const epics::pvData::BitSet::shared_pointer& O);
+// Convert a field of a Value to python as attribute access would.
+PyObject *P4PValue_fetch(PyObject *value, epics::pvData::PVField *fld);
+// Find a sub-field of a Value by (dotted) name, as attribute access would, or NULL
+epics::pvData::PVField *P4PValue_lookup(PyObject *value, const std::string& name);
+// numpy array sharing storage with a numeric (non-string) array
+PyObject *P4PValue_ndarray(const array_type& arr);
+
+// NT helpers
+PyObject* p4p_ntscalar_unwrap(PyObject *junk, PyObject *args);
+PyObject* p4p_nturi_encode(PyObject *junk, PyObject *args, PyObject *kws);
+PyObject* p4p_nturi_type(PyObject *junk, PyObject *args);
+PyObject* p4p_nturi_decode(PyObject *junk, PyObject *args);
 
 
 template<class C>
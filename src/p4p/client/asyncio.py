@@ -0,0 +1,309 @@
+
+from __future__ import absolute_import
+
+import logging
+_log = logging.getLogger(__name__)
+
+import json, socket, threading
+from collections import deque
+from functools import partial
+
+import asyncio
+
+from . import raw
+from ..wrapper import Value, Type
+from ..nt import _default_unwrap
+
+__all__ = [
+    'Context',
+    'Value',
+    'Type',
+]
+
+try:
+    unicode
+except NameError:
+    unicode = str
+
+class Subscription(object):
+    """An active subscription.  An asynchronous iterator of Values.
+
+    >>> async for V in ctxt.monitor('pv:name'):
+    ...     print(V)
+
+    Iteration ends when the subscription completes.
+    Errors are raised from the iteration, which may then be continued.
+    """
+    def __init__(self, ctxt, name, request):
+        self._ctxt, self.name = ctxt, name
+        self._waiter = None
+        self._errors = deque()
+        self._S = ctxt._channel(name).monitor(partial(ctxt._call, self._event), request)
+        ctxt._subs[self._S] = self
+        ctxt._sel.add(self._S)
+
+    def close(self):
+        """Close subscription.
+        """
+        if self._S is not None:
+            self._ctxt._sel.remove(self._S)
+            self._ctxt._subs.pop(self._S, None)
+            self._S.close()
+            self._S = None
+        W, self._waiter = self._waiter, None
+        if W is not None and not W.done():
+            W.set_exception(StopAsyncIteration())
+
+    @property
+    def done(self):
+        'Has all data for this subscription been received?'
+        return self._S is None or self._S.done()
+
+    def __aiter__(self):
+        return self
+
+    def __anext__(self):
+        F = self._ctxt.loop.create_future()
+        if self._S is None:
+            F.set_exception(StopAsyncIteration())
+        else:
+            self._waiter = F
+            self._next()
+        return F
+
+    def _event(self, E):
+        # errors and completion, in the event loop
+        if E is not None:
+            self._errors.append(E)
+        self._next()
+
+    def _next(self):
+        # called when an update may be available, in the event loop
+        F = self._waiter
+        if F is None or F.done() or self._S is None:
+            return
+        if self._errors:
+            self._waiter = None
+            F.set_exception(self._errors.popleft())
+            return
+        V = self._S.pop()
+        if V is not None:
+            self._waiter = None
+            F.set_result(self._ctxt._dounwrap(V))
+        elif self._S.done():
+            self._waiter = None
+            F.set_exception(StopAsyncIteration())
+        # else the Selector will report when an update arrives
+
+class Context(object):
+    """Context(provider, conf=None, useenv=True, unwrap=None, loop=None)
+
+    :param str provider: A Provider name.  Try "pva" or run :py:meth:`Context.providers` for a complete list.
+    :param conf dict: Configuration to pass to provider.  Depends on provider selected.
+    :param useenv bool: Allow the provider to use configuration from the process environment.
+    :param unwrap: Controls :ref:`unwrap`.  Set False to disable
+    :param loop: The asyncio event loop.  Default is the current event loop.
+
+    Other keyword arguments (eg. idleTimeout) are passed to :py:class:`p4p.client.raw.Context`.
+
+    The get(), put(), and rpc() methods return :py:class:`asyncio.Future` s,
+    so any number of operations may be in progress at once.
+
+    >>> ctxt = Context('pva')
+    >>> V = await ctxt.get('pv:name')
+    >>> A, B = await asyncio.gather(ctxt.get('pv:1'), ctxt.get('pv:2'))
+
+    Completions from all operations are collected, and handed to the event loop
+    through a single file descriptor.  Subscription updates are reported
+    through a :py:class:`p4p.client.raw.Selector`.
+    """
+    Value = Value
+
+    name = ''
+    "Provider name string"
+
+    providers = raw.Context.providers
+    set_debug = raw.Context.set_debug
+
+    def __init__(self, provider, conf=None, useenv=True, unwrap=None, loop=None, **kws):
+        if unwrap is None:
+            self._unwrap = _default_unwrap
+        elif not unwrap:
+            self._unwrap = {}
+        elif isinstance(unwrap, dict):
+            self._unwrap = _default_unwrap.copy()
+            self._unwrap.update(unwrap)
+        else:
+            raise ValueError("unwrap must be None, False, or dict, not %s"%unwrap)
+
+        self.loop = loop or asyncio.get_event_loop()
+        self._ctxt = raw.Context(provider, conf=conf, useenv=useenv, **kws)
+        self.name = self._ctxt.name
+
+        self._subs = {}
+
+        # (callable, arg) pairs queued from PVA worker threads
+        self._pending = deque()
+        self._lock = threading.Lock()
+        self._signaled = False # guarded by _lock
+        # portable, unlike a pipe w/ fcntl()
+        self._rsock, self._wsock = socket.socketpair()
+        for S in (self._rsock, self._wsock):
+            S.setblocking(False)
+        self.loop.add_reader(self._rsock.fileno(), self._wakeup)
+
+        self._sel = raw.Selector()
+        self.loop.add_reader(self._sel.fileno(), self._ready)
+
+    def close(self):
+        """Force close all Channels and cancel all Operations
+        """
+        if self._ctxt is None:
+            return
+        for S in list(self._subs.values()):
+            S.close()
+        self.loop.remove_reader(self._sel.fileno())
+        self.loop.remove_reader(self._rsock.fileno())
+        self._sel.close()
+        self._rsock.close()
+        self._wsock.close()
+        self._ctxt.close()
+        self._ctxt = None
+
+    def __enter__(self):
+        return self
+    def __exit__(self,A,B,C):
+        self.close()
+
+    def _dounwrap(self, val):
+        fn = self._unwrap.get(val.getID())
+        if fn:
+            val = fn(val)
+        return val
+
+    def _channel(self, name):
+        # connections are cached by raw.Context
+        return self._ctxt.channel(name)
+
+    def _call(self, fn, arg):
+        # from a PVA worker thread.  run fn(arg) in the event loop
+        self._pending.append((fn, arg))
+        with self._lock:
+            if self._signaled:
+                return
+            self._signaled = True
+        self._wsock.send(b'!')
+
+    def _wakeup(self):
+        with self._lock:
+            self._signaled = False
+            try:
+                self._rsock.recv(4096)
+            except socket.error:
+                pass # nothing to read
+        while True:
+            try:
+                fn, arg = self._pending.popleft()
+            except IndexError:
+                break
+            try:
+                fn(arg)
+            except:
+                _log.exception("Error delivering completion %s", arg)
+
+    def _ready(self):
+        for S in self._sel.ready():
+            S = self._subs.get(S)
+            if S is not None:
+                S._next()
+
+    def _settle(self, F, value):
+        if F.done():
+            pass # cancelled
+        elif isinstance(value, Exception):
+            F.set_exception(value)
+        elif value is None:
+            F.set_result(None)
+        else:
+            F.set_result(self._dounwrap(value))
+
+    def _start(self, F, op):
+        # cancel the operation if the Future is cancelled
+        def done(F):
+            if F.cancelled():
+                op.cancel()
+        F.add_done_callback(done)
+        return F
+
+    def get(self, name, request=None):
+        """Fetch current value of a PV.
+
+        :param str name: PV name string
+        :param request: None or a Value to qualify this request
+        :returns: A Future for a Value.  Or an Exception
+
+        Use eg. :py:func:`asyncio.wait_for` to apply a timeout.
+        """
+        F = self.loop.create_future()
+        op = self._channel(name).get(partial(self._call, partial(self._settle, F)), request=request)
+        return self._start(F, op)
+
+    def put(self, name, value, request=None):
+        """Write a new value to a PV.
+
+        :param str name: PV name string
+        :param value: A Value, dict, or plain value
+        :param request: None or a Value to qualify this request
+        :returns: A Future for None.  Or an Exception
+
+        Unless the provided value is a dict, it is assumed to be a plain value
+        and an attempt is made to store it in '.value' field.
+        """
+        if isinstance(value, (bytes, unicode)) and value[:1]=='{':
+            try:
+                value = json.loads(value)
+            except ValueError:
+                raise ValueError("Unable to interpret '%s' as json"%value)
+
+        F = self.loop.create_future()
+        cb = partial(self._call, partial(self._settle, F))
+
+        # callback to build PVD Value from PY value
+        def vb(type):
+            try:
+                if isinstance(value, dict):
+                    V = self.Value(type, value)
+                else:
+                    V = self.Value(type, {})
+                    V.value = value # will try to cast str -> *
+                return V
+            except Exception as E:
+                _log.exception("Error building put value %s", value)
+                cb(E)
+                raise E
+
+        op = self._channel(name).put(cb, vb, request=request)
+        return self._start(F, op)
+
+    def rpc(self, name, value, request=None):
+        """Perform a Remote Procedure Call (RPC) operation
+
+        :param str name: PV name string
+        :param Value value: Arguments.  Must be Value instance
+        :param request: None or a Value to qualify this request
+        :returns: A Future for a Value.  Or an Exception
+        """
+        F = self.loop.create_future()
+        op = self._channel(name).rpc(partial(self._call, partial(self._settle, F)), value, request)
+        return self._start(F, op)
+
+    Subscription = Subscription
+
+    def monitor(self, name, request=None):
+        """Create a subscription.
+
+        :param str name: PV name string
+        :param request: None or a Value to qualify this request
+        :returns: a :py:class:`Subscription` instance, which is an asynchronous iterator.
+        """
+        return self.Subscription(self, name, request)
@@ -11,13 +11,17 @@ except ImportError:
     from queue import Queue, Full, Empty
 
 from .._p4p import (Context as _Context,
-                   Channel as _Channel)
+                   Channel as _Channel,
+                   Dispatcher as _Dispatcher,
+                   Selector)
 from .._p4p import logLevelDebug
 
 from ..wrapper import Value
 
 __all__ = (
     'Context',
+    'Dispatcher',
+    'Selector',
 )
 
 class Channel(_Channel):
@@ -30,9 +34,8 @@ class Context(_Context):
     def __init__(self, *args, **kws):
         _Context.__init__(self, *args, **kws)
         _all_contexts.add(self)
-        # we keep strong refs here to shadow the Channel refs
-        # from the underlying Provider, which we can't get at.
-        self._channels = set()
+        # Channels are cached by _Context, and closed by _Context.close()
+        self._channels = WeakSet()
 
     def close(self):
         if self._channels is not None:
@@ -48,11 +51,20 @@ class Context(_Context):
         self._channels.add(ch)
         return ch
 
+class Dispatcher(_Dispatcher):
+    def __init__(self, *args, **kws):
+        _Dispatcher.__init__(self, *args, **kws)
+        _all_dispatchers.add(self)
+
 _all_contexts = WeakSet()
+_all_dispatchers = WeakSet()
 
 def _cleanup_contexts():
     contexts = list(_all_contexts)
     for ctxt in contexts:
         ctxt.close()
+    # workers must not wait for the GIL during interpreter shutdown
+    for D in list(_all_dispatchers):
+        D.close()
 
 atexit.register(_cleanup_contexts)
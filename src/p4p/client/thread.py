@@ -4,17 +4,8 @@ from __future__ import print_function
 import logging, warnings
 _log = logging.getLogger(__name__)
 
-try:
-    from itertools import izip
-except ImportError:
-    izip = zip
 from functools import partial
-import json, threading
-
-try:
-    from Queue import Queue, Full, Empty
-except ImportError:
-    from queue import Queue, Full, Empty
+import json
 
 try:
     unicode
@@ -24,10 +15,10 @@ except:
 
 from . import raw
 from ..wrapper import Value, Type
-from ..rpc import WorkQueue
 from .._p4p import (logLevelAll, logLevelTrace, logLevelDebug,
                     logLevelInfo, logLevelWarn, logLevelError,
                     logLevelFatal, logLevelOff)
+from .._p4p import TimeoutError as _TimeoutError
 from ..nt import _default_wrap, _default_unwrap
 
 __all__ = [
@@ -36,30 +27,50 @@ __all__ = [
     'Type',
 ]
 
-class TimeoutError(RuntimeError):
+class TimeoutError(_TimeoutError):
     def __init__(self):
-        RuntimeError.__init__(self, 'Timeout')
+        _TimeoutError.__init__(self, 'Timeout')
 Timeout = TimeoutError()
 
+def _ignore(V):
+    pass
+
+def _timeout(T):
+    # *_many() wait forever when <0
+    return -1.0 if T is None else T
+
 class Subscription(object):
     """An active subscription.
     """
+    _batch = 64 # max. updates popped at once
     def __init__(self, ctxt, name, cb):
         self._dounwrap = ctxt._dounwrap
+        self._dispatch = ctxt._dispatch
         self.name, self._S, self._cb = name, None, cb
-        self._Q = ctxt._queue()
+        self._stats = {'updates':0, 'overruns':0, 'maxdepth':0} # last from self._S
     def close(self):
         """Close subscription.
         """
         if self._S is not None:
-            E = threading.Event()
+            self._stats = self._S.stats()
             # after .close() self._event should never be called
             self._S.close()
-            # now wait for any pending calls to self._handle
-            # TODO: detect when called from worker and avoid deadlock
-            self._Q.push_wait(E.set)
-            E.wait()
+            # now wait for any callback in progress.  Returns immediately if called from a callback
+            self._dispatch.sync()
             self._S = None
+    def stats(self):
+        """Subscription statistics
+        
+        :returns: A dict with keys
+
+        * 'updates' - Number of updates received.
+        * 'overruns' - Number of updates where the server squashed some intermediate changes.  See :py:meth:`Value.overrun`
+        * 'maxdepth' - Largest number of updates found queued for this subscription
+        """
+        S = self._S
+        if S is not None:
+            self._stats = S.stats()
+        return self._stats.copy()
     @property
     def done(self):
         'Has all data for this subscription been received?'
@@ -69,33 +80,35 @@ class Subscription(object):
         'Is data pending in event queue?'
         return self._S is None or self._S.empty()
     def _event(self, E):
-        try:
-            assert self._S is not None, self._S
-            #TODO: ensure ordering of error and data events
-            _log.debug('Subscription wakeup for %s with %s', self.name, E)
-            self._inprog = True
-            self._Q.push(partial(self._handle, E))
-        except:
-            _log.exception("Lost Subscription update: %s", E)
+        # from a Dispatcher worker, in order with other events of this channel
+        _log.debug('Subscription wakeup for %s with %s', self.name, E)
+        self._handle(E)
     def _handle(self, E):
+        S = self._S
         try:
             if E is not None:
                 self._cb(E)
                 return
+            elif S is None:
+                return # closed, or before monitor() has set _S, which then calls again
             while True:
-                E = self._S.pop()
-                if E is None:
+                # drain in batches to limit per-update overhead
+                Es = S.pop_many(self._batch)
+                if not Es:
                     break
-                E = self._dounwrap(E)
-                self._cb(E)
-            if self._S.done():
+                for E in Es:
+                    E = self._dounwrap(E)
+                    self._cb(E)
+            if S.done():
                 _log.debug("Subscription complete")
-                self._S.close()
+                self._stats = S.stats()
+                S.close()
                 self._S = None
                 self._cb(None)
         except:
             _log.exception("Error processing Subscription event: %s", E)
-            self._S.close()
+            if S is not None:
+                S.close()
             self._S = None
 
 class Context(object):
@@ -104,8 +117,11 @@ class Context(object):
     :param str provider: A Provider name.  Try "pva" or run :py:meth:`Context.providers` for a complete list.
     :param conf dict: Configuration to pass to provider.  Depends on provider selected.
     :param useenv bool: Allow the provider to use configuration from the process environment.
-    :param maxsize int: Size of internal work queue used for monitor callbacks
+    :param int workers: Number of threads which run monitor() callbacks
+    :param maxsize int: Deprecated, and ignored.  Callbacks are queued without limit.
     :param unwrap: Controls :ref:`unwrap`.  Set False to disable
+    :param float idleTimeout: Seconds to keep a connection to a PV after it was last used.
+    :param int maxIdle: Maximum number of unused connections to keep.
 
     The methods of this Context will block the calling thread until completion or timeout
 
@@ -128,7 +144,10 @@ class Context(object):
 
     def __init__(self, *args, **kws):
         _log.debug("thread.Context with %s %s", args, kws)
-        self._Qmax = kws.pop('maxsize', 0)
+        if kws.pop('maxsize', None) is not None:
+            warnings.warn("Context(maxsize=) is ignored.  Callbacks are queued without limit.",
+                          DeprecationWarning, stacklevel=2)
+        workers = kws.pop('workers', 1)
         unwrap = kws.pop('unwrap', None)
         if unwrap is None:
             self._unwrap = _default_unwrap
@@ -139,13 +158,12 @@ class Context(object):
             self._unwrap.update(unwrap)
         else:
             raise ValueError("unwrap must be None, False, or dict, not %s"%unwrap)
-        self._ctxt = raw.Context(*args, **kws)
-        self.name = self._ctxt.name
-
-        self._channels = {}
 
-        # lazy start threaded WorkQueue
-        self._Q, self._T = None, None
+        # callbacks are run by these workers, instead of PVA threads.
+        # threads are started when first needed
+        self._dispatch = raw.Dispatcher(workers=workers)
+        self._ctxt = raw.Context(*args, dispatcher=self._dispatch, **kws)
+        self.name = self._ctxt.name
 
     def _dounwrap(self, val):
         fn = self._unwrap.get(val.getID())
@@ -153,27 +171,15 @@ class Context(object):
             val = fn(val)
         return val
 
-    def _queue(self):
-        if self._Q is None:
-            Q = WorkQueue(maxsize=self._Qmax)
-            T = threading.Thread(name='p4p Context worker', target=Q.handle)
-            T.daemon = True
-            T.start()
-            self._Q, self._T = Q, T
-        return self._Q
-
     def close(self):
         """Force close all Channels and cancel all Operations
         """
-        if self._Q is not None:
-            self._Q.interrupt()
-            self._T.join()
-            self._Q, self._T = None, None
-        self._channels = None
         self._ctxt.close()
+        # runs callbacks already queued
+        self._dispatch.close()
 
     def __del__(self):
-        if self._Q is not None:
+        if self._dispatch.stats()['workers']:
             warnings.warn("%s collected without close()"%self.__class__)
         self.close()
 
@@ -183,18 +189,27 @@ class Context(object):
         self.close()
 
     def _channel(self, name):
-        try:
-            return self._channels[name]
-        except KeyError:
-            self._channels[name] = ch = self._ctxt.channel(name)
-            return ch
+        # connections are cached by raw.Context
+        return self._ctxt.channel(name)
+
+    def _results(self, result, throw):
+        # map a list of results from raw.Context.*_many()
+        for i,R in enumerate(result):
+            if isinstance(R, _TimeoutError):
+                result[i] = R = Timeout
+            if isinstance(R, Exception):
+                if throw:
+                    raise R
+            elif R is not None:
+                result[i] = self._dounwrap(R)
+        return result
 
     def get(self, name, request=None, timeout=5.0, throw=True):
         """Fetch current value of some number of PVs.
         
         :param name: A single name string or list of name strings
         :param request: None or a Value to qualify this request
-        :param float timeout: Operation timeout in seconds
+        :param float timeout: Operation timeout in seconds.  None to wait forever
         :param bool throw: When true, operation error throws an exception.  If False then the Exception is returned instead of the Value
 
         :returns: A Value or Exception, or list of same
@@ -213,47 +228,11 @@ class Context(object):
             if request is not None:
                 request = [request]
 
-        if request is None:
-            request = [None]*len(name)
-
-        assert len(name)==len(request), (name, request)
-
-        # use Queue instead of Event to allow KeyboardInterrupt
-        done = Queue(maxsize=len(name))
-        result = [Timeout]*len(name)
-        ops = [None]*len(name)
-
-        try:
-            for i,(N, req) in enumerate(izip(name, request)):
-                _log.debug('gext %s', N)
-                ch = self._channel(N)
-                def cb(value, i=i):
-                    try:
-                        done.put_nowait((value, i))
-                    except:
-                        _log.exception("Error queuing get result %s", value)
-                _log.debug('get %s w/ %s', N, req)
-                ops[i] = ch.get(cb, request=req)
-
-            for _n in range(len(name)):
-                try:
-                    value, i = done.get(timeout=timeout)
-                except Empty:
-                    if throw:
-                        raise Timeout
-                    break
-                _log.debug('got %s %s', name[i], value)
-                if throw and isinstance(value, Exception):
-                    raise value
-                result[i] = value
-
-        finally:
-            [op and op.cancel() for op in ops]
+        # waits w/o GIL for all operations to complete
+        result = self._ctxt.get_many(name, request, _timeout(timeout))
 
-        print('XYZ', self._unwrap, result)
-        result = [self._dounwrap(R) for R in result]
+        result = self._results(result, throw)
 
-        print('XYZ', result)
         if singlepv:
             return result[0]
         else:
@@ -265,7 +244,7 @@ class Context(object):
         :param name: A single name string or list of name strings
         :param values: A single value or a list of values
         :param request: None or a Value to qualify this request
-        :param float timeout: Operation timeout in seconds
+        :param float timeout: Operation timeout in seconds.  None to wait forever
         :param bool throw: When true, operation error throws an exception.
                      If False then the Exception is returned instead of the Value
 
@@ -293,66 +272,49 @@ class Context(object):
             if request is not None:
                 request = [request]
 
-        if request is None:
-            request = [None]*len(name)
-
-        assert len(name)==len(request), (name, request)
         assert len(name)==len(values), (name, values)
 
-        # use Queue instead of Event to allow KeyboardInterrupt
-        done = Queue(maxsize=len(name))
-        result = [Timeout]*len(name)
-        ops = [None]*len(name)
-
-        try:
-            for i,(name, value, req) in enumerate(izip(name, values, request)):
-                if isinstance(value, (bytes, unicode)) and value[:1]=='{':
-                    try:
-                        value = json.loads(value)
-                    except ValueError:
-                        raise ValueError("Unable to interpret '%s' as json"%value)
-
-                ch = self._channel(name)
-
-                # callback to build PVD Value from PY value
-                def vb(type, value=value, i=i):
-                    try:
-                        if isinstance(value, dict):
-                            V = self.Value(type, value)
-                        else:
-                            V = self.Value(type, {})
-                            V.value = value # will try to cast str -> *
-                        return V
-                    except Exception as E:
-                        _log.exception("Error building put value %s", value)
-                        done.put_nowait((E, i))
-                        raise E
-
-                # completion callback
-                def cb(value, i=i):
-                    try:
-                        done.put_nowait((value, i))
-                    except:
-                        _log.exception("Error queuing put result %s", value)
-                ops[i] = ch.put(cb, vb, request=req)
-
-            for _n in range(len(name)):
+        builders = []
+        for N, value in zip(name, values):
+            if isinstance(value, (bytes, unicode)) and value[:1]=='{':
                 try:
-                    value, i = done.get(timeout=timeout)
-                except Empty:
-                    if throw:
-                        raise Timeout
-                    break
-                if throw and isinstance(value, Exception):
-                    raise value
-                result[i] = value
+                    value = json.loads(value)
+                except ValueError:
+                    raise ValueError("Unable to interpret '%s' as json"%value)
 
-            if singlepv:
-                return result[0]
+            # callback to build PVD Value from PY value
+            def vb(type, value=value):
+                try:
+                    if isinstance(value, dict):
+                        V = self.Value(type, value)
+                    else:
+                        V = self.Value(type, {})
+                        V.value = value # will try to cast str -> *
+                    return V
+                except Exception as E:
+                    _log.exception("Error building put value %s", value)
+                    raise E
+
+            # when the type of the PV is known, build the Value now instead of
+            # from a PVA worker.  Otherwise fetch the type for next time.
+            ch = self._channel(N)
+            T = ch.type()
+            if T is None:
+                # completes, and fills the cache, even once the Operation is collected
+                ch.type(_ignore)
             else:
-                return result
-        finally:
-            [op and op.cancel() for op in ops]
+                vb = vb(T)
+            builders.append(vb)
+
+        # waits w/o GIL for all operations to complete
+        result = self._ctxt.put_many(name, builders, request, _timeout(timeout))
+
+        result = self._results(result, throw)
+
+        if singlepv:
+            return result[0]
+        else:
+            return result
 
     def rpc(self, name, value, request=None, timeout=5.0, throw=True):
         """Perform a Remote Procedure Call (RPC) operation
@@ -360,7 +322,7 @@ class Context(object):
         :param str name: PV name string
         :param Value value: Arguments.  Must be Value instance
         :param request: None or a Value to qualify this request
-        :param float timeout: Operation timeout in seconds
+        :param float timeout: Operation timeout in seconds.  None to wait forever
         :param bool throw: When true, operation error throws an exception.
                      If False then the Exception is returned instead of the Value
 
@@ -379,39 +341,57 @@ class Context(object):
         Unless the provided value is a dict, it is assumed to be a plan value
         and an attempt is made to store it in '.value' field.
         """
-        done = Queue(maxsize=1)
+        result = self._ctxt.rpc_many([name], [value], [request], _timeout(timeout))
 
-        ch = self._channel(name)
-        op = ch.rpc(done.put_nowait, value, request)
-        try:
-            try:
-                result = done.get(timeout=timeout)
-            except Empty:
-                result = Timeout
-            if throw and isinstance(result, Exception):
-                raise result
-
-            return self._dounwrap(result)
-        except:
-            op.cancel()
-            raise
+        return self._results(result, throw)[0]
+
+    def connect_many(self, names, timeout=5.0, keep=None):
+        """Connect to many PVs at once, for example before a scan.
+
+        :param names: A list of name strings
+        :param float timeout: Seconds to wait for all to connect.  None to wait forever
+        :param float keep: Seconds to keep these connections, even if unused.
+        :returns: A tuple of two sets of names. (connected, unconnected)
+
+        Waits, with the GIL released, until all are connected or timeout.
+        Connections are then kept for re-use by later operations.
+        With keep=None they are unused, so closed after idleTimeout,
+        and any more than maxIdle are closed by the next operation.
+        Otherwise they are kept for at least keep seconds, whatever maxIdle,
+        and idleTimeout applies from then.
+
+        >>> ctxt = Context('pva')
+        >>> ok, missing = ctxt.connect_many(['pv:1', 'pv:2'], keep=600.0)
+        """
+        return self._ctxt.connect_many(names, _timeout(timeout), keep)
 
     Subscription = Subscription
 
-    def monitor(self, name, cb, request=None):
+    def monitor(self, name, cb, request=None, borrow=False, queueSize=None, pipeline=None, ackAny=None):
         """Create a subscription.
         
         :param str name: PV name string
         :param callable cb: Processing callback
         :param request: None or a Value to qualify this request
+        :param bool borrow: If True, the Value passed to cb() references the received update without a copy.
+                            The update is released to the server queue when this Value
+                            (and any object referencing it, eg. an unwrapped .raw) is collected.
+                            A consumer which holds on to Values will then apply flow control.
+        :param int queueSize: Depth of the server and client update queues.  None for provider default.
+        :param bool pipeline: If True, the server sends at most queueSize updates which have not been acknowledged.
+                              Updates are acknowledged as they are popped, in batches before cb() is called for each
+                              (or when collected, with borrow=True).  The next batch is only popped once cb() has
+                              returned, so a slow cb() throttles the server instead of overflowing the client queue.
+        :param ackAny: Acknowledge after this many updates have been processed.  An int, or a percentage
+                       of queueSize (eg. "50%").  None for provider default.
         :returns: a :py:class:`Subscription` instance
         """
         R = self.Subscription(self, name, cb)
         ch = self._channel(name)
 
-        R._S = ch.monitor(R._event, request)
-        try:
-            return R
-        except:
-            S.close()
-            raise
+        R._S = ch.monitor(R._event, request, borrow=borrow,
+                          queueSize=queueSize, pipeline=pipeline, ackAny=ackAny)
+        # in case an update was notified before _S was set.
+        # after the events of this channel already queued.  harmless if the queue is empty.
+        self._dispatch.push(partial(R._handle, None), ch)
+        return R
@@ -10,7 +10,10 @@ except ImportError:
 import time
 from collections import OrderedDict
 from operator import itemgetter
+
+import numpy
 from ..wrapper import Type, Value
+from .._p4p import _nturi_encode, _nturi_decode, _nturi_type
 from .common import timeStamp, alarm
 from .scalar import NTScalar
 
@@ -102,7 +105,22 @@ class NTTable(object):
             {'A':42, 'B':'one'},
             {'A':43, 'B':'two'},
         ])
+
+        Also accepts a dict of columns (eg. numpy arrays),
+        or a numpy structured array, which are stored without iterating rows.
+
+        >>> V = T.wrap({'A':numpy.asarray([42, 43]), 'B':['one', 'two']})
         """
+        if isinstance(values, numpy.ndarray) and values.dtype.names is not None:
+            values = OrderedDict([(L, values[L]) for L in self.labels if L in values.dtype.names])
+
+        if isinstance(values, dict):
+            # already columns
+            return self.Value(self.type, {
+                'labels': self.labels,
+                'value': values,
+            })
+
         cols = dict([(L, []) for L in self.labels])
         try:
             # unzip list of dict
@@ -152,6 +170,33 @@ class NTTable(object):
             # zip together column names and row values
             yield OrderedDict(zip(lbl, rval))
 
+    @staticmethod
+    def unwrap_columns(value):
+        """Columns of an NTTable
+
+        :returns: An OrderedDict of column name and value.
+                  Numeric columns are numpy arrays which share storage with the Value.
+                  String columns are lists.
+        """
+        return OrderedDict(value.value.items())
+
+    @staticmethod
+    def unwrap_array(value):
+        """Copy an NTTable into a numpy structured array
+
+        :returns: A numpy.ndarray with one field per column.
+                  String columns have dtype object.
+        """
+        cols = value.value.items()
+        nrows = max([len(C) for _n, C in cols] or [0])
+
+        dtype = [(str(name), C.dtype if isinstance(C, numpy.ndarray) else object) for name, C in cols]
+        ret = numpy.zeros(nrows, dtype=dtype)
+        for name, C in cols:
+            # short columns leave zero/None
+            ret[str(name)][:len(C)] = C
+        return ret
+
 class NTURI(object):
     @staticmethod
     def buildType(args):
@@ -159,22 +204,28 @@ class NTURI(object):
 
         :param list args: A list of tuples of query argument name and type code.
         """
-        return Type(id="epics:nt/NTURI:1.0", spec=[
-            ('scheme', 's'),
-            ('authority', 's'),
-            ('path', 's'),
-            ('query', ('S', None, args)),
-        ])
+        return _nturi_type(tuple([(name, code) for name, code in args]))
     def __init__(self, args):
-        self.type = self.buildType(args)
+        # signature tuple keys a cache of Types shared by all instances
+        self._sig = tuple([(name, code) for name, code in args])
+        self.type = _nturi_type(self._sig)
 
     def wrap(self, path, args, scheme='', authority=''):
-        return Value(self.type, {
-            'scheme':scheme,
-            'authority':authority,
-            'path':path,
-            'query': args,
-        })
+        """Build an NTURI Value
+
+        :param str path: Typically the PV name
+        :param dict args: Query arguments
+        :returns: A Value of self.type, with no fields marked changed
+        """
+        return _nturi_encode(self._sig, path, args, scheme=scheme, authority=authority)
+
+    @staticmethod
+    def unwrap(value):
+        """Unpack an NTURI
+
+        :returns: A tuple of path string and dict of query arguments
+        """
+        return _nturi_decode(value)
 
     _typeMap = {
         float: 'd',
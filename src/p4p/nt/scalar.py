@@ -4,6 +4,7 @@ import numpy
 
 from ..wrapper import Type, Value
 from .common import alarm, timeStamp
+from .._p4p import _ntscalar_unwrap
 
 _doc = """
 Has additional attributes
@@ -158,12 +159,11 @@ class NTScalar(object):
         """Unpack a Value into an augmented python type (selected from the 'value' field)
         """
         assert isinstance(value, Value), value
-        V = value.value
         try:
-            T = klass.typeMap[type(V)]
-        except KeyError:
-            raise ValueError("Can't unwrap value of type %s"%type(V))
-        try:
-            return T(value.value)._store(value)
+            # equivalent to T(value.value)._store(value)
+            return _ntscalar_unwrap(klass.typeMap, value)
         except Exception as e:
+            T = klass.typeMap.get(type(getattr(value, 'value', None)))
+            if T is None:
+                raise # no .value, or of a type which can't be unwrapped
             raise ValueError("Can't construct %s around %s (%s): %s"%(T, value, type(value), e))
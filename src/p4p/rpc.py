@@ -78,6 +78,9 @@ class WorkQueue(object):
         self._Q.put_nowait(callable) # throws Queue.Full
     def push_wait(self, callable):
         self._Q.put(callable)
+    def qsize(self):
+        "Approximate number of pending entries"
+        return self._Q.qsize()
     def interrupt(self):
         """Break one call to handle()
 
@@ -198,7 +201,7 @@ class NTURIDispatcher(RPCDispatcherBase):
 
     def getMethodNameArgs(self, request):
         # {'schema':'pva', 'path':'pvname', 'query':{'var':'val', ...}}
-        return request.path, dict(request.query.items())
+        return NTURI.unwrap(request)
 
 # legecy for MASAR only
 # do not use in new code
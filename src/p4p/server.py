@@ -9,6 +9,8 @@ from ._p4p import (Server as _Server,
                    removeProvider,
                    clearProviders,
                    RPCReply,
+                   GetReply,
+                   MonitorSub,
                    )
 
 class Server(object):
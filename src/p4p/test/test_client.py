@@ -3,9 +3,25 @@ from __future__ import print_function
 
 import unittest
 import weakref, gc
-
-from ..client.raw import Context
+import select
+import threading
+import random
+import time
+import warnings
+try:
+    from Queue import Queue
+except ImportError:
+    from queue import Queue
+from functools import partial
+
+from ..client.raw import Context, Selector, Dispatcher
+
+try:
+    import asyncio
+except ImportError:
+    asyncio = None
 from ..wrapper import Value, Type
+from ..server import Server, installProvider, removeProvider
 
 class TestRequest(unittest.TestCase):
     def testEmpty(self):
@@ -41,6 +57,136 @@ class TestPVA(unittest.TestCase):
 
         self.assertEqual(chan.getName(), "completelyInvalidChannelName")
 
+    def testChannelPool(self):
+        ctxt = Context("pva", maxIdle=1)
+        try:
+            A = ctxt.channel("completelyInvalidChannelName")
+            B = ctxt.channel("completelyInvalidChannelName")
+            self.assertDictEqual(ctxt.poolStats(), {'channels':1, 'idle':0})
+
+            A.close()
+            self.assertRaises(RuntimeError, A.getName)
+            self.assertEqual(B.getName(), "completelyInvalidChannelName")
+            self.assertDictEqual(ctxt.poolStats(), {'channels':1, 'idle':0})
+
+            del B
+            gc.collect()
+            self.assertDictEqual(ctxt.poolStats(), {'channels':1, 'idle':1})
+
+            C = ctxt.channel("anotherInvalidChannelName")
+            self.assertDictEqual(ctxt.poolStats(), {'channels':2, 'idle':1})
+            C.close()
+
+            # oldest unused channel is dropped when maxIdle is exceeded
+            D = ctxt.channel("anotherInvalidChannelName")
+            self.assertDictEqual(ctxt.poolStats(), {'channels':1, 'idle':0})
+        finally:
+            ctxt.close()
+        self.assertDictEqual(ctxt.poolStats(), {'channels':0, 'idle':0})
+
+    def testGetMany(self):
+        from .._p4p import TimeoutError
+        self.assertListEqual(self.ctxt.get_many([], timeout=0.1), [])
+
+        R = self.ctxt.get_many(["completelyInvalidChannelName", "anotherInvalidChannelName"], timeout=0.1)
+        self.assertEqual(len(R), 2)
+        self.assertIsInstance(R[0], TimeoutError)
+        self.assertIsInstance(R[1], TimeoutError)
+
+        self.assertRaises(ValueError, self.ctxt.get_many, ["completelyInvalidChannelName"], [None, None])
+        self.assertRaises(ValueError, self.ctxt.put_many, ["completelyInvalidChannelName"], [])
+
+    def testConnectMany(self):
+        self.assertEqual(self.ctxt.connect_many([], timeout=0.1), (set(), set()))
+
+        names = ["completelyInvalidChannelName", "anotherInvalidChannelName", "completelyInvalidChannelName"]
+        C, U = self.ctxt.connect_many(names, timeout=0.1)
+        self.assertSetEqual(C, set())
+        self.assertSetEqual(U, set(names))
+        # kept in the pool
+        self.assertDictEqual(self.ctxt.poolStats(), {'channels':2, 'idle':2})
+
+    def testConnectManyMaxIdle(self):
+        ctxt = Context("pva", maxIdle=1)
+        names = ["completelyInvalidChannelName", "anotherInvalidChannelName"]
+        try:
+            # more than maxIdle.  The excess is closed by the next operation
+            C, U = ctxt.connect_many(names, timeout=0.1)
+            self.assertSetEqual(U, set(names))
+            self.assertDictEqual(ctxt.poolStats(), {'channels':2, 'idle':2})
+            ctxt.get_many([], timeout=0.1)
+            self.assertDictEqual(ctxt.poolStats(), {'channels':1, 'idle':1})
+
+            # unless kept
+            C, U = ctxt.connect_many(names, timeout=0.1, keep=0.5)
+            self.assertSetEqual(U, set(names))
+            self.assertDictEqual(ctxt.poolStats(), {'channels':2, 'idle':0})
+            ctxt.get_many([], timeout=0.1)
+            self.assertDictEqual(ctxt.poolStats(), {'channels':2, 'idle':0})
+
+            # then unused
+            time.sleep(0.6)
+            ctxt.get_many([], timeout=0.1)
+            self.assertDictEqual(ctxt.poolStats(), {'channels':1, 'idle':1})
+
+            self.assertRaises(ValueError, ctxt.connect_many, names, timeout=0.1, keep=-1.0)
+        finally:
+            ctxt.close()
+
+    def testConvert(self):
+        # put() conversion into the type of the PV
+        chan = self.ctxt.channel("completelyInvalidChannelName")
+        T = Type([
+            ('value', 'ad'),
+            ('alarm', ('S', None, [
+                ('severity', 'i'),
+                ('message', 's'),
+            ])),
+        ])
+
+        # match by name, and convert scalar and array elements
+        S = Value(Type([
+            ('alarm', ('S', None, [
+                ('severity', 'l'),
+            ])),
+            ('value', 'ai'),
+        ]), {'value':[1, 2], 'alarm':{'severity':2}})
+        V = chan._convert(S, T)
+        self.assertListEqual(list(V.value), [1.0, 2.0])
+        self.assertEqual(V.alarm.severity, 2)
+        self.assertSetEqual(V.asSet(), set(['value', 'alarm.severity']))
+
+        # only changed fields
+        S = Value(Type([('value', 'ai'), ('extra', 'i')]), {})
+        S.value = [3]
+        V = chan._convert(S, T, changed=True)
+        self.assertListEqual(list(V.value), [3.0])
+        self.assertSetEqual(V.asSet(), set(['value']))
+
+        # nothing to copy, and nothing marked
+        V = chan._convert(Value(Type([('value', 'ai')]), {}), T, changed=True)
+        self.assertSetEqual(V.asSet(), set())
+
+        # a changed field with no match
+        S.extra = 1
+        self.assertRaises(RuntimeError, chan._convert, S, T, changed=True)
+        # any field with no match, when putting the whole structure
+        self.assertRaises(RuntimeError, chan._convert, Value(Type([('value', 'ai'), ('extra', 'i')]), {}), T)
+        # no match at all
+        self.assertRaises(RuntimeError, chan._convert, Value(Type([('other', 'i')]), {}), T)
+        # nothing to copy
+        self.assertRaises(RuntimeError, chan._convert, Value(Type([]), {}), T)
+        # Can't convert scalar to array
+        self.assertRaises(RuntimeError, chan._convert, Value(Type([('value', 's')]), {}), T)
+
+        # plans are cached by type.  Each type is kept alive by its plan, so can't be confused with a new one.
+        for i in range(40):
+            S = Value(Type([('value', 'ai'), ('f%d'%i, 'i')]), {'value':[i]})
+            T = Type([('value', 'ad'), ('f%d'%i, 'd')])
+            V = chan._convert(S, T)
+            self.assertListEqual(list(V.value), [float(i)])
+            self.assertSetEqual(V.asSet(), set(['value', 'f%d'%i]))
+
     def testGetAbort(self):
         chan = self.ctxt.channel("completelyInvalidChannelName")
         _X = [None]
@@ -86,6 +232,65 @@ class TestPVA(unittest.TestCase):
 
         self.assertIsNone(_X[0])
 
+    def testType(self):
+        chan = self.ctxt.channel("completelyInvalidChannelName")
+        _X = [None]
+        def fn(V):
+            _X[0] = V
+
+        self.assertIsNone(chan.type())
+
+        op = chan.type(fn)
+        self.assertTrue(op.cancel())
+        self.assertIsNone(_X[0])
+        self.assertIsNone(chan.type())
+
+    def testGetter(self):
+        chan = self.ctxt.channel("completelyInvalidChannelName")
+        _X = [None]
+        def fn(V):
+            _X[0] = V
+        G = chan.getter()
+
+        G.get(fn)
+        self.assertRaises(RuntimeError, G.get, fn)
+
+        G.close()
+        self.assertRaises(RuntimeError, G.get, fn)
+        self.assertIsNone(_X[0])
+
+        G = chan.getter(recycle=True)
+        G.get(fn)
+        W = weakref.ref(G)
+        del G
+        gc.collect()
+
+        self.assertIsNone(W())
+        self.assertIsNone(_X[0])
+
+    def testPutter(self):
+        chan = self.ctxt.channel("completelyInvalidChannelName")
+        _X = [None]
+        def fn(V):
+            _X[0] = V
+        P = chan.putter()
+
+        # not connected
+        self.assertIsNone(P.type())
+        self.assertIsNone(P.value())
+
+        V = Value(Type([('value', 'i')]), {'value':5})
+        P.put(fn, V)
+        self.assertRaises(RuntimeError, P.put, fn, V)
+        self.assertRaises(TypeError, P.put, fn, 5)
+
+        W = weakref.ref(P)
+        del P
+        gc.collect()
+
+        self.assertIsNone(W())
+        self.assertIsNone(_X[0])
+
     def testRPCAbort(self):
         P = Value(Type([
             ('value', 'i'),
@@ -106,6 +311,31 @@ class TestPVA(unittest.TestCase):
 
         self.assertIsNone(_X[0])
 
+    def testTimeout(self):
+        from .._p4p import TimeoutError
+        chan = self.ctxt.channel("completelyInvalidChannelName")
+        V = Value(Type([('value', 'i')]), {'value':5})
+
+        for start in (partial(chan.get, timeout=0.1),
+                      partial(chan.put, value=V, timeout=0.1),
+                      partial(chan.rpc, value=V, timeout=0.1),
+                      partial(chan.monitor, timeout=0.1)):
+            done = threading.Event()
+            _X = []
+            def fn(V):
+                _X.append(V)
+                done.set()
+            op = start(fn)
+
+            self.assertTrue(done.wait(5.0))
+            self.assertEqual(len(_X), 1)
+            self.assertIsInstance(_X[0], TimeoutError)
+            # already cancelled
+            if hasattr(op, 'cancel'):
+                self.assertFalse(op.cancel())
+            else:
+                op.close()
+
     def testMonAbort(self):
         chan = self.ctxt.channel("completelyInvalidChannelName")
 
@@ -141,3 +371,574 @@ class TestPVA(unittest.TestCase):
         self.assertIsNone(W())
 
         self.assertIs(_X[0], canery)
+
+    def testMonBorrow(self):
+        chan = self.ctxt.channel("completelyInvalidChannelName")
+
+        canery = object()
+        _X = [canery]
+        def evt(V):
+            _X[0] = V
+
+        op = chan.monitor(evt, borrow=True)
+
+        self.assertIsNone(op.pop()) # never connected
+        self.assertListEqual(op.pop_many(), [])
+        self.assertListEqual(op.pop_many(max=10), [])
+        self.assertDictEqual(op.pop_columns(['value', 'alarm.severity']),
+                             {'value':[], 'alarm.severity':[]})
+        self.assertDictEqual(op.stats(), {'updates':0, 'overruns':0, 'maxdepth':0})
+
+        op.close()
+
+        self.assertIs(_X[0], canery)
+
+    def testMonFlowControl(self):
+        chan = self.ctxt.channel("completelyInvalidChannelName")
+
+        def evt(V):
+            pass
+
+        op = chan.monitor(evt, 'field(value)record[ackAny=2]', queueSize=4, pipeline=True)
+        op.close()
+
+        op = chan.monitor(evt, queueSize=4, pipeline=True, ackAny='50%')
+        op.close()
+
+        self.assertRaises(ValueError, chan.monitor, evt, queueSize=0)
+        self.assertRaises(ValueError, chan.monitor, evt, ackAny=-1)
+
+    def testSelector(self):
+        chan = self.ctxt.channel("completelyInvalidChannelName")
+
+        def evt(V):
+            pass
+
+        S = Selector()
+        try:
+            self.assertIsInstance(S.fileno(), int)
+            self.assertListEqual(S.ready(), [])
+            self.assertListEqual(select.select([S], [], [], 0)[0], [])
+
+            op = chan.monitor(evt)
+            S.add(op)
+
+            # add() always reports once, in case updates are already queued
+            self.assertListEqual(select.select([S], [], [], 0)[0], [S])
+            self.assertListEqual(S.ready(), [op])
+            self.assertListEqual(select.select([S], [], [], 0)[0], [])
+            self.assertListEqual(S.ready(), [])
+
+            self.assertIsNone(op.pop())
+
+            S.remove(op)
+            op.close()
+        finally:
+            S.close()
+
+        self.assertRaises(ValueError, S.fileno)
+
+class GetProvider(object):
+    "Serves one PV, counting get()s"
+    channelType = Type([
+        ('value', 'i'),
+        ('alarm', ('S', None, [
+            ('severity', 'i'),
+        ])),
+    ])
+    def __init__(self, name):
+        self.name, self.count = name, 0
+    def testChannel(self, name):
+        return name==self.name
+    def makeChannel(self, name, src):
+        if name==self.name:
+            return self
+    def get(self, reply):
+        self.count += 1
+        reply.done(reply=Value(self.channelType, {'value':self.count, 'alarm':{'severity':self.count}}))
+
+class LateTypeProvider(GetProvider):
+    "Has no channelType, so refuses get, until one is given"
+    T = None
+    @property
+    def channelType(self):
+        if self.T is None:
+            raise AttributeError('channelType')
+        return self.T
+
+class TestServer(unittest.TestCase):
+    "raw client of a local server"
+    def setUp(self):
+        conf = {
+            'EPICS_PVAS_INTF_ADDR_LIST':'127.0.0.1',
+            'EPICS_PVA_ADDR_LIST':'127.0.0.1',
+            'EPICS_PVA_AUTO_ADDR_LIST':'0',
+            'EPICS_PVA_SERVER_PORT':'0',
+            'EPICS_PVA_BROADCAST_PORT':'0',
+        }
+        self.name = 'clienttest:%u:pv'%random.randint(0, 1024)
+        installProvider("TestClient", GetProvider(self.name))
+        self.server = Server(providers="TestClient", conf=conf, useenv=False)
+        self.server.start()
+        self.ctxt = Context('pva', useenv=False, conf=self.server.conf(client=True, server=False))
+
+    def tearDown(self):
+        self.ctxt.close()
+        self.server.stop()
+        removeProvider("TestClient")
+        self.ctxt = self.server = None
+        gc.collect()
+
+    def testGetterRecycle(self):
+        G = self.ctxt.channel(self.name).getter(recycle=True)
+        Q = Queue()
+        def get():
+            G.get(Q.put)
+            V = Q.get(timeout=5.0)
+            if isinstance(V, Exception):
+                raise V
+            return V
+
+        V = get()
+        self.assertEqual(V.value, 1)
+
+        # a sub-structure keeps the storage of V from being re-used
+        A = V.alarm
+        del V
+        V = get()
+        self.assertEqual(V.value, 2)
+        self.assertEqual(A.severity, 1)
+
+        del V, A
+        V = get()
+        self.assertEqual(V.value, 3)
+        self.assertEqual(V.alarm.severity, 3)
+        G.close()
+
+        self.assertRaises(TypeError, self.ctxt.channel(self.name).getter, recycle=NotBool())
+
+class MonitorProvider(object):
+    "Serves one PV, keeping the server end of each subscription"
+    channelType = Type([
+        ('value', 'i'),
+    ])
+    def __init__(self, name):
+        self.name, self.subs = name, []
+    def testChannel(self, name):
+        return name==self.name
+    def makeChannel(self, name, src):
+        if name==self.name:
+            return self
+    def monitor(self, sub):
+        self.subs.append(sub)
+
+class TestServerMonitor(unittest.TestCase):
+    "raw client of a local server's monitor()"
+    def setUp(self):
+        conf = {
+            'EPICS_PVAS_INTF_ADDR_LIST':'127.0.0.1',
+            'EPICS_PVA_ADDR_LIST':'127.0.0.1',
+            'EPICS_PVA_AUTO_ADDR_LIST':'0',
+            'EPICS_PVA_SERVER_PORT':'0',
+            'EPICS_PVA_BROADCAST_PORT':'0',
+        }
+        self.name = 'clienttest:%u:mon'%random.randint(0, 1024)
+        self.provider = MonitorProvider(self.name)
+        installProvider("TestClientMon", self.provider)
+        self.server = Server(providers="TestClientMon", conf=conf, useenv=False)
+        self.server.start()
+        self.ctxt = Context('pva', useenv=False, conf=self.server.conf(client=True, server=False))
+
+    def tearDown(self):
+        self.ctxt.close()
+        self.server.stop()
+        removeProvider("TestClientMon")
+        self.ctxt = self.server = self.provider = None
+        gc.collect()
+
+    def testMonitor(self):
+        Q = Queue()
+        S = self.ctxt.channel(self.name).monitor(Q.put)
+
+        # the server end is created once the client connects
+        T0 = time.time()
+        while not self.provider.subs:
+            self.assertLess(time.time()-T0, 5.0)
+            time.sleep(0.01)
+        sub = self.provider.subs[0]
+
+        self.assertTrue(sub.post(Value(MonitorProvider.channelType, {'value':42})))
+        self.assertIsNone(Q.get(timeout=5.0))
+        V = S.pop()
+        self.assertEqual(V.value, 42)
+        S.close()
+
+class TestLocalProvider(unittest.TestCase):
+    "a client Context named after a server provider uses it directly, without a Server"
+    def setUp(self):
+        self.name = 'clienttest:%u:local'%random.randint(0, 1024)
+        self.provider = GetProvider(self.name)
+        installProvider("TestLocal", self.provider)
+
+    def tearDown(self):
+        removeProvider("TestLocal")
+        self.provider = None
+        gc.collect()
+
+    def get(self, ctxt):
+        Q = Queue()
+        ctxt.channel(self.name).get(Q.put)
+        V = Q.get(timeout=5.0)
+        if isinstance(V, Exception):
+            raise V
+        return V
+
+    def testGet(self):
+        ctxt = Context("TestLocal")
+        try:
+            self.assertEqual(self.get(ctxt).value, 1)
+            self.assertEqual(self.provider.count, 1)
+        finally:
+            ctxt.close()
+
+        # closing a Context leaves the provider to others
+        ctxt = Context("TestLocal")
+        try:
+            self.assertEqual(self.get(ctxt).value, 2)
+        finally:
+            ctxt.close()
+
+    def testGetMany(self):
+        ctxt = Context("TestLocal")
+        try:
+            R = ctxt.get_many([self.name, self.name], timeout=5.0)
+            self.assertListEqual(sorted(V.value for V in R), [1, 2])
+        finally:
+            ctxt.close()
+
+    def testGetterRefused(self):
+        removeProvider("TestLocal")
+        self.provider = LateTypeProvider(self.name)
+        installProvider("TestLocal", self.provider)
+
+        ctxt = Context("TestLocal")
+        try:
+            G = ctxt.channel(self.name).getter()
+            Q = Queue()
+            G.get(Q.put)
+            self.assertIsInstance(Q.get(timeout=5.0), RuntimeError)
+
+            # each get() asks again
+            self.provider.T = GetProvider.channelType
+            G.get(Q.put)
+            self.assertEqual(Q.get(timeout=5.0).value, 1)
+            G.close()
+        finally:
+            ctxt.close()
+
+    def testRemoved(self):
+        removeProvider("TestLocal")
+        try:
+            self.assertRaises(RuntimeError, Context, "TestLocal")
+        finally:
+            installProvider("TestLocal", self.provider)
+
+class TestBorrow(unittest.TestCase):
+    "client of a provider in this process, so both ends of a monitor queue are visible"
+    def setUp(self):
+        self.name = 'clienttest:%u:mon'%random.randint(0, 1024)
+        self.provider = MonitorProvider(self.name)
+        installProvider("TestBorrow", self.provider)
+        self.ctxt = Context("TestBorrow")
+
+    def tearDown(self):
+        self.ctxt.close()
+        removeProvider("TestBorrow")
+        self.ctxt = self.provider = None
+        gc.collect()
+
+    def post(self, sub, val):
+        return sub.post(Value(MonitorProvider.channelType, {'value':val}))
+
+    def testBorrow(self):
+        E = []
+        S = self.ctxt.channel(self.name).monitor(E.append, queueSize=2, borrow=True)
+        self.assertEqual(len(self.provider.subs), 1)
+        sub = self.provider.subs[0]
+
+        self.assertTrue(self.post(sub, 1))
+        self.assertTrue(self.post(sub, 2))
+        self.assertFalse(self.post(sub, 3)) # queue full
+        self.assertListEqual(E, [None])
+
+        A, B = S.pop(), S.pop()
+        self.assertIsNone(S.pop())
+        self.assertEqual((A.value, B.value), (1, 2))
+
+        # popped, but still in use by the borrowed Values
+        self.assertFalse(self.post(sub, 3))
+
+        del B
+        gc.collect()
+        self.assertTrue(self.post(sub, 3))
+        self.assertFalse(self.post(sub, 4))
+
+        C = S.pop()
+        self.assertEqual(C.value, 3)
+        self.assertEqual(A.value, 1) # not overwritten
+
+        del A, C
+        gc.collect()
+        self.assertTrue(self.post(sub, 4))
+        self.assertTrue(self.post(sub, 5))
+        S.close()
+
+    def testCopy(self):
+        S = self.ctxt.channel(self.name).monitor(lambda E:None, queueSize=2)
+        sub = self.provider.subs[0]
+
+        self.assertTrue(self.post(sub, 1))
+        A = S.pop()
+        # without borrow=True, the element is released by pop()
+        self.assertTrue(self.post(sub, 2))
+        self.assertTrue(self.post(sub, 3))
+        self.assertEqual(A.value, 1)
+        S.close()
+
+    def testMaxDepth(self):
+        S = self.ctxt.channel(self.name).monitor(lambda E:None, queueSize=4)
+        sub = self.provider.subs[0]
+
+        for i in range(3):
+            self.assertTrue(self.post(sub, i))
+        self.assertListEqual([V.value for V in S.pop_many()], [0, 1, 2])
+        self.assertDictEqual(S.stats(), {'updates':3, 'overruns':0, 'maxdepth':3})
+
+        self.assertTrue(self.post(sub, 3))
+        self.assertEqual(S.pop().value, 3)
+        self.assertIsNone(S.pop())
+        self.assertDictEqual(S.stats(), {'updates':4, 'overruns':0, 'maxdepth':3})
+        S.close()
+
+    def testBorrowNotBool(self):
+        self.assertRaises(TypeError, self.ctxt.channel(self.name).monitor, lambda E:None, borrow=NotBool())
+
+    def options(self, *args, **kws):
+        "subscribe, returning the server end and the record._options it receives"
+        S = self.ctxt.channel(self.name).monitor(lambda E:None, *args, **kws)
+        sub = self.provider.subs.pop()
+        opts = sub.pvRequest()['record._options']
+        return S, sub, dict((k, opts[k]) for k in opts.keys())
+
+    def testFlowControl(self):
+        S, sub, opts = self.options(queueSize=4, pipeline=True, ackAny=2)
+        self.assertDictEqual(opts, {'queueSize':'4', 'pipeline':'true', 'ackAny':'2'})
+        # the server has queueSize elements
+        for i in range(4):
+            self.assertTrue(self.post(sub, i))
+        self.assertFalse(self.post(sub, 4))
+        S.close()
+
+        S, sub, opts = self.options(ackAny='50%')
+        self.assertDictEqual(opts, {'ackAny':'50%'})
+        S.close()
+
+        S, sub, opts = self.options(pipeline=False)
+        self.assertDictEqual(opts, {'pipeline':'false'})
+        S.close()
+
+        # merged with the request
+        S, sub, opts = self.options('field(value)record[ackAny=2]', queueSize=4, pipeline=True)
+        self.assertDictEqual(opts, {'queueSize':'4', 'pipeline':'true', 'ackAny':'2'})
+        S.close()
+
+        # keyword arguments override the request
+        S, sub, opts = self.options('record[queueSize=2,pipeline=true]', queueSize=8)
+        self.assertDictEqual(opts, {'queueSize':'8', 'pipeline':'true'})
+        for i in range(8):
+            self.assertTrue(self.post(sub, i))
+        self.assertFalse(self.post(sub, 8))
+        S.close()
+
+class ColumnProvider(MonitorProvider):
+    channelType = Type([
+        ('value', 'd'),
+        ('alarm', ('S', None, [
+            ('severity', 'i'),
+            ('message', 's'),
+        ])),
+    ])
+
+class TestPopColumns(unittest.TestCase):
+    def setUp(self):
+        self.name = 'clienttest:%u:cols'%random.randint(0, 1024)
+        self.provider = ColumnProvider(self.name)
+        installProvider("TestPopColumns", self.provider)
+        self.ctxt = Context("TestPopColumns")
+
+    def tearDown(self):
+        self.ctxt.close()
+        removeProvider("TestPopColumns")
+        self.ctxt = self.provider = None
+        gc.collect()
+
+    def post(self, sub, i):
+        return sub.post(Value(ColumnProvider.channelType, {
+            'value':i*0.5,
+            'alarm.severity':i,
+            'alarm.message':'msg%d'%i,
+        }))
+
+    def testPop(self):
+        S = self.ctxt.channel(self.name).monitor(lambda E:None, queueSize=8)
+        sub = self.provider.subs[0]
+        fields = ['value', 'alarm.severity', 'alarm.message']
+
+        # connected, so an empty batch has the field types
+        C = S.pop_columns(fields)
+        self.assertEqual(C['value'].dtype.name, 'float64')
+        self.assertEqual(C['alarm.severity'].dtype.name, 'int32')
+        self.assertListEqual(C['alarm.message'], [])
+        self.assertRaises(KeyError, S.pop_columns, ['invalid'])
+
+        for i in range(5):
+            self.assertTrue(self.post(sub, i))
+
+        # a bad name takes nothing
+        self.assertRaises(KeyError, S.pop_columns, ['value', 'invalid'])
+        self.assertRaises(KeyError, S.pop_columns, ['alarm'])
+        self.assertEqual(S.stats()['updates'], 0)
+
+        C = S.pop_columns(fields, max=3)
+        self.assertListEqual(C['value'].tolist(), [0.0, 0.5, 1.0])
+        self.assertListEqual(C['alarm.severity'].tolist(), [0, 1, 2])
+        self.assertListEqual(C['alarm.message'], ['msg0', 'msg1', 'msg2'])
+
+        C, O = S.pop_columns(fields, overrun=True)
+        self.assertListEqual(C['value'].tolist(), [1.5, 2.0])
+        self.assertListEqual(C['alarm.message'], ['msg3', 'msg4'])
+        self.assertListEqual(O['alarm.severity'].tolist(), [False, False])
+        self.assertEqual(S.stats()['updates'], 5)
+        self.assertListEqual(S.pop_columns(['value'])['value'].tolist(), [])
+
+        # every element was released
+        for i in range(8):
+            self.assertTrue(self.post(sub, i))
+        self.assertFalse(self.post(sub, 8))
+        S.close()
+
+class NotBool(object):
+    def __bool__(self):
+        raise TypeError("not a bool")
+    __nonzero__ = __bool__
+
+class TestThread(unittest.TestCase):
+    def setUp(self):
+        from ..client.thread import Context as TContext
+        self.ctxt = TContext("pva")
+    def tearDown(self):
+        self.ctxt.close()
+        self.ctxt = None
+        gc.collect()
+
+    def testTimeoutNone(self):
+        # wait forever
+        self.assertListEqual(self.ctxt.get([], timeout=None), [])
+        self.assertListEqual(self.ctxt.put([], [], timeout=None), [])
+        self.assertEqual(self.ctxt.connect_many([], timeout=None), (set(), set()))
+
+    def testMaxSize(self):
+        from ..client.thread import Context as TContext
+        with warnings.catch_warnings(record=True) as W:
+            warnings.simplefilter('always')
+            TContext("pva", maxsize=4).close()
+        self.assertListEqual([w.category for w in W], [DeprecationWarning])
+
+class TestDispatcher(unittest.TestCase):
+    def tearDown(self):
+        gc.collect()
+
+    def testPush(self):
+        D = Dispatcher(workers=2)
+        try:
+            # threads started when first needed
+            self.assertDictEqual(D.stats(), {'workers':0, 'maxdepth':0})
+
+            X = []
+            for i in range(10):
+                D.push(partial(X.append, i))
+            D.sync()
+
+            self.assertListEqual(sorted(X), list(range(10)))
+            self.assertEqual(D.stats()['workers'], 2)
+        finally:
+            D.close()
+
+        self.assertRaises(RuntimeError, D.push, X.append)
+        D.sync() # no-op once closed
+        self.assertRaises(ValueError, Dispatcher, workers=0)
+
+    def testOrdered(self):
+        D = Dispatcher(workers=4)
+        ctxt = Context("pva", dispatcher=D)
+        try:
+            chan = ctxt.channel("completelyInvalidChannelName")
+
+            X = []
+            for i in range(100):
+                D.push(partial(X.append, i), chan)
+            D.sync()
+
+            self.assertListEqual(X, list(range(100)))
+
+            op = chan.get(X.append)
+            self.assertTrue(op.cancel())
+        finally:
+            ctxt.close()
+            D.close()
+
+        self.assertRaises(TypeError, Context, "pva", dispatcher=object())
+
+    def testCollected(self):
+        D = Dispatcher()
+        started, release, done = threading.Event(), threading.Event(), threading.Event()
+        def work():
+            started.set()
+            release.wait(5.0)
+            done.set()
+        D.push(work)
+        self.assertTrue(started.wait(5.0))
+
+        # does not wait for the worker
+        del D
+        gc.collect()
+        self.assertFalse(done.is_set())
+
+        release.set()
+        self.assertTrue(done.wait(5.0))
+
+@unittest.skipIf(asyncio is None, "asyncio not available")
+class TestAsyncio(unittest.TestCase):
+    def setUp(self):
+        from ..client.asyncio import Context as AContext
+        self.loop = asyncio.new_event_loop()
+        self.ctxt = AContext("pva", loop=self.loop)
+    def tearDown(self):
+        self.ctxt.close()
+        self.loop.close()
+        self.ctxt = self.loop = None
+        gc.collect()
+
+    def testGetTimeout(self):
+        F = self.ctxt.get("completelyInvalidChannelName")
+        self.assertRaises(asyncio.TimeoutError, self.loop.run_until_complete,
+                          asyncio.wait_for(F, 0.1))
+        self.assertTrue(F.cancelled())
+
+    def testMonitorClose(self):
+        S = self.ctxt.monitor("completelyInvalidChannelName")
+        self.assertIs(S.__aiter__(), S)
+        N = S.__anext__()
+        self.assertFalse(N.done())
+        S.close()
+        self.assertRaises(StopAsyncIteration, self.loop.run_until_complete, N)
@@ -53,10 +53,53 @@ class TestScalar(unittest.TestCase):
         P = nt.NTScalar.unwrap(V)
         self.assertEqual(P, value)
         self.assertEqual(P.severity, 1)
+        self.assertEqual(P.status, 0)
+        self.assertIs(P.raw, V)
+
+    def test_unwrap_stamp(self):
+        V = nt.NTScalar('i').wrap({
+            'value':42,
+            'timeStamp':{
+                'secondsPastEpoch':1000,
+                'nanoseconds':500000000,
+            },
+        })
+
+        P = nt.NTScalar.unwrap(V)
+        self.assertEqual(P, 42)
+        self.assertEqual(P.raw_stamp, (1000, 500000000))
+        self.assertAlmostEqual(P.timestamp, 1000.5)
+
+    def test_unwrap_minimal(self):
+        # alarm and timeStamp are optional
+        V = Value(Type([('value', 'd')], id="epics:nt/NTScalar:1.0"), {'value':4.5})
+
+        P = nt.NTScalar.unwrap(V)
+        self.assertEqual(P, 4.5)
+        self.assertEqual(P.severity, 0)
+        self.assertEqual(P.timestamp, 0.0)
 
     test_int_unwrap = partial(test_float_unwrap, code='i', value=42)
     test_str_unwrap = partial(test_float_unwrap, code='s', value='foo')
 
+    def test_unwrap_error(self):
+        V = nt.NTScalar('i').wrap(42)
+
+        class Broken(int):
+            def __init__(self, val):
+                raise RuntimeError("oops")
+        class BrokenScalar(nt.NTScalar):
+            typeMap = {int: Broken}
+        try:
+            BrokenScalar.unwrap(V)
+            self.fail("No exception")
+        except ValueError as e:
+            # names the type selected
+            self.assertIn('Broken', str(e))
+            self.assertIn('oops', str(e))
+
+        self.assertRaises(ValueError, nt.NTScalar.unwrap, Value(Type([('x', 'd')]), {}))
+
     def test_array_wrap(self):
         NT = nt.NTScalar('ad') # array of double
 
@@ -110,3 +153,91 @@ class TestTable(unittest.TestCase):
             OrderedDict([('a', 5), ('b', u'one')]),
             OrderedDict([('a', 6), ('b', u'two')]),
         ])
+
+    def test_wrap_columns(self):
+        NT = nt.NTTable(columns=[
+            ('a', 'i'),
+            ('b', 's'),
+        ])
+        V = NT.wrap({
+            'a': numpy.arange(5),
+            'b': ['one', 'two', 'three', 'four', 'five'],
+        })
+
+        assert_aequal(V.value.a, [0, 1, 2, 3, 4])
+        self.assertEqual(V.value.b, ['one', 'two', 'three', 'four', 'five'])
+        self.assertEqual(V.labels, ['a', 'b'])
+
+        A = numpy.zeros(3, dtype=[('a', 'i4'), ('b', object)])
+        A['a'] = [7, 8, 9]
+        A['b'] = ['x', 'y', 'z']
+        V = NT.wrap(A)
+
+        assert_aequal(V.value.a, [7, 8, 9])
+        self.assertEqual(V.value.b, ['x', 'y', 'z'])
+
+    def test_unwrap_columns(self):
+        T = nt.NTTable.buildType(columns=[
+            ('a', 'ai'),
+            ('b', 'as'),
+        ])
+        V = Value(T, {
+            'labels': ['a', 'b'],
+            'value':{
+                'a': [5, 6],
+                'b': ['one', 'two'],
+            },
+        })
+
+        C = nt.NTTable.unwrap_columns(V)
+        self.assertListEqual(list(C.keys()), ['a', 'b'])
+        assert_aequal(C['a'], [5, 6])
+        self.assertEqual(C['b'], ['one', 'two'])
+
+        A = nt.NTTable.unwrap_array(V)
+        self.assertEqual(A.shape, (2,))
+        self.assertEqual(A.dtype.names, ('a', 'b'))
+        assert_aequal(A['a'], [5, 6])
+        self.assertEqual(list(A['b']), ['one', 'two'])
+
+class TestURI(unittest.TestCase):
+    def test_wrap_unwrap(self):
+        NT = nt.NTURI([
+            ('a', 'i'),
+            ('b', 's'),
+        ])
+
+        V = NT.wrap('pv:name', {'a':5, 'b':'hello'}, scheme='pva')
+        self.assertEqual(V.getID(), 'epics:nt/NTURI:1.0')
+        self.assertEqual(V.scheme, 'pva')
+        self.assertEqual(V.authority, '')
+        self.assertEqual(V.path, 'pv:name')
+        self.assertEqual(V.query.a, 5)
+        self.assertEqual(V.query.b, 'hello')
+
+        path, args = nt.NTURI.unwrap(V)
+        self.assertEqual(path, 'pv:name')
+        self.assertDictEqual(args, {'a':5, 'b':'hello'})
+
+        # same signature re-uses Type
+        V2 = nt.NTURI([('a', 'i'), ('b', 's')]).wrap('pv:other', {'a':6})
+        self.assertEqual(V2.query.a, 6)
+        self.assertEqual(V2.type().aspy(), V.type().aspy())
+
+        self.assertRaises(KeyError, NT.wrap, 'pv:name', {'invalid':1})
+
+    def test_type(self):
+        NT = nt.NTURI([
+            ('a', 'i'),
+            ('b', 's'),
+        ])
+        V = NT.wrap('pv:name', {'a':5}, scheme='pva')
+
+        # the Type built by the encoder
+        self.assertEqual(V.type().aspy(), NT.type.aspy())
+        self.assertEqual(NT.type.aspy(), nt.NTURI.buildType([('a', 'i'), ('b', 's')]).aspy())
+        self.assertEqual(NT.type.getID(), 'epics:nt/NTURI:1.0')
+
+        # as constructed from a dict, nothing is marked
+        self.assertSetEqual(V.asSet(), set())
+        self.assertSetEqual(Value(NT.type, {'path':'pv:name', 'query':{'a':5}}).asSet(), set())
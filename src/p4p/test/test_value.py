@@ -7,7 +7,7 @@ import unittest
 import numpy as np
 from numpy.testing import assert_array_almost_equal as assert_aequal
 
-from .._p4p import (Type as _Type, Value as _Value)
+from .._p4p import (Type as _Type, Value as _Value, Array as _Array)
 from ..wrapper import Value
 from .. import pvdVersion
 
@@ -93,6 +93,67 @@ class TestRawValue(unittest.TestCase):
         self.assertRaises(KeyError, V.__setitem__, 'foo', 5)
         self.assertRaises(AttributeError, setattr, V, 'foo', 5)
 
+    def testNestedFieldAccess(self):
+        T = _Type([
+            ('a', 'i'),
+            ('b', ('S', None, [
+                ('c', 'i'),
+                ('d', ('S', None, [
+                    ('e', 'd'),
+                ])),
+            ])),
+            ('f', 's'),
+        ])
+        V = _Value(T, {'a':1, 'b':{'c':2, 'd':{'e':3.5}}, 'f':'x'})
+        V2 = _Value(T, {'a':5}) # same type, shares field lookup
+
+        self.assertEqual(V['a'], 1)
+        self.assertEqual(V['b.c'], 2)
+        self.assertEqual(V['b.d.e'], 3.5)
+        self.assertEqual(V.b.d['e'], 3.5)
+        self.assertEqual(V.f, 'x')
+        self.assertEqual(V2.a, 5)
+        self.assertEqual(V2['b.d.e'], 0.0)
+        self.assertRaises(KeyError, V.__getitem__, 'b.x')
+        self.assertRaises(KeyError, V.b.__getitem__, 'a')
+
+        V['b.d.e'] = 4.5
+        self.assertEqual(V.b.d.e, 4.5)
+        self.assertTrue(V.changed('b.d.e'))
+        self.assertFalse(V.changed('b.c'))
+
+    def testNestedFieldMethods(self):
+        V = _Value(_Type([
+            ('a', 'i'),
+            ('b', ('S', 'foo', [
+                ('c', 'ad'),
+                ('u', ('U', None, [
+                    ('i', 'i'),
+                    ('s', 's'),
+                ])),
+            ])),
+        ]), {'a':1, 'b':{'c':[1.5, 2.5], 'u':('i', 4)}})
+
+        assert_aequal(V.getarray('b.c', dtype='i4'), np.asarray([1, 2]))
+        self.assertRaises(KeyError, V.getarray, 'a')
+        self.assertRaises(KeyError, V.getarray, 'b.x')
+
+        self.assertListEqual([K for K, _V in V.tolist('b')], ['c', 'u'])
+        self.assertListEqual([K for K, _V in V.items('b')], ['c', 'u'])
+        self.assertRaises(KeyError, V.tolist, 'b.x')
+        self.assertEqual(V.type('b').getID(), 'foo')
+        self.assertRaises(KeyError, V.type, 'a')
+
+        V.select('b.u', 's')
+        V['b.u'] = 'x'
+        self.assertEqual(V.b.u, u'x')
+        self.assertRaises(KeyError, V.select, 'a', None)
+
+        # clearing unions is broken prior to 7.0.0
+        if pvdVersion()>=(7,0,0,0):
+            V.select('b.u', None)
+            self.assertIsNone(V.b.u)
+
     def testBadField(self):
         T = _Type([
             ('ival', 'i'),
@@ -116,6 +177,147 @@ class TestRawValue(unittest.TestCase):
         assert_aequal(V.dval, np.asfarray([1.1, 2.2]))
         self.assertListEqual(V.sval, [u'a', u'b'])
 
+    def testArrayDType(self):
+        V = _Value(_Type([
+            ('ival', 'ai'),
+            ('dval', 'ad'),
+            ('sval', 'as'),
+        ]), {
+            'ival': [1, 2, 3],
+            'dval': np.asfarray([1.5, 2.5]),
+            'sval': ['a', u'b'],
+        })
+
+        A = V.getarray('ival', dtype=np.float32)
+        self.assertEqual(A.dtype, np.float32)
+        assert_aequal(A, np.asarray([1, 2, 3]))
+
+        A = V.getarray('dval', dtype='i2')
+        self.assertEqual(A.dtype, np.int16)
+        assert_aequal(A, np.asarray([1, 2]))
+
+        A = V.getarray('ival')
+        self.assertEqual(A.dtype, np.int32)
+
+        self.assertListEqual(V.getarray('sval'), [u'a', u'b'])
+        self.assertRaises(TypeError, V.getarray, 'sval', dtype='f8')
+        self.assertRaises(KeyError, V.getarray, 'invalid')
+
+        # store converts from the assigned dtype
+        V.dval = np.asarray([4, 5, 6], dtype=np.int16)
+        self.assertEqual(V.dval.dtype, np.float64)
+        assert_aequal(V.dval, np.asfarray([4, 5, 6]))
+
+        V.ival = np.asarray([True, False])
+        assert_aequal(V.ival, np.asarray([1, 0]))
+
+        # assignment marks an array field as changed, as it does a scalar
+        W = _Value(V.type())
+        W.dval = np.asarray([7], dtype=np.int16) # converted
+        W.ival = [8]
+        W.sval = ['c']
+        self.assertSetEqual(W.asSet(), {'dval', 'ival', 'sval'})
+
+        # float to integer is only defined for values in range
+        V.dval = np.asfarray([1e10, np.nan])
+        self.assertRaises(ValueError, V.getarray, 'dval', dtype=np.int8)
+        self.assertRaises(ValueError, V.getarray, 'dval', dtype=np.uint64)
+        V.dval = np.asfarray([np.nan])
+        self.assertRaises(ValueError, V.getarray, 'dval', dtype='i4')
+        self.assertRaises(ValueError, setattr, V, 'ival', np.asfarray([1.0, np.inf]))
+        V.dval = np.asfarray([127.5, -128.5])
+        assert_aequal(V.getarray('dval', dtype=np.int8), np.asarray([127, -128]))
+        self.assertRaises(ValueError, V.getarray, 'dval', dtype=np.uint8)
+        assert_aequal(V.getarray('dval', dtype=np.float32), np.asarray([127.5, -128.5]))
+
+    def testArrayPool(self):
+        T = _Type([('dval', 'ad')])
+        V = _Value(T, {})
+
+        V.dval = np.arange(100, dtype=np.float64)
+        S0 = _Array.poolStats()
+
+        for i in range(10):
+            # previous array released on each assignment
+            V.dval = np.arange(100, dtype=np.float64)
+
+        S1 = _Array.poolStats()
+        self.assertGreaterEqual(S1['reuse']-S0['reuse'], 9)
+        self.assertLessEqual(S1['alloc'], S0['alloc']+1)
+        assert_aequal(V.dval, np.arange(100))
+
+        A = V.dval
+        del V
+        gc.collect()
+        # numpy array keeps the buffer alive
+        assert_aequal(A, np.arange(100))
+
+    def testArrayPoolClass(self):
+        V = _Value(_Type([('dval', 'ad')]), {})
+        V.dval = np.arange(1025, dtype=np.float64) # 8200 bytes
+
+        S0 = _Array.poolStats()
+        del V
+        gc.collect()
+        S1 = _Array.poolStats()
+
+        # returned buffer is at most 25% larger than needed
+        self.assertEqual(S1['return']-S0['return'], 1)
+        self.assertGreaterEqual(S1['cached']-S0['cached'], 8200)
+        self.assertLessEqual(S1['cached']-S0['cached'], 8200*5//4)
+
+    def testStringIntern(self):
+        V = _Value(_Type([
+            ('sval', 's'),
+            ('aval', 'as'),
+        ]), {
+            'sval': 'units',
+            'aval': ['one', 'two'],
+        })
+
+        _Value.internConfig()
+        S0 = _Value.internStats()
+
+        self.assertIs(V.sval, V.sval)
+        L1, L2 = V.aval, V.aval
+        self.assertListEqual(L1, ['one', 'two'])
+        self.assertIsNot(L1, L2) # lists are not shared
+        self.assertIs(L1[0], L2[0])
+
+        S1 = _Value.internStats()
+        self.assertEqual(S1['strHit']-S0['strHit'], 1)
+        self.assertEqual(S1['arrHit']-S0['arrHit'], 1)
+        self.assertEqual(S1['arrays'], 1)
+
+        # new buffer
+        V.aval = ['one', 'three']
+        self.assertListEqual(V.aval, ['one', 'three'])
+
+        _Value.internConfig(maxLength=0)
+        self.assertEqual(V.sval, 'units')
+        self.assertEqual(_Value.internStats()['strings'], 0)
+        _Value.internConfig(maxLength=128)
+
+    def testInternEvict(self):
+        T = _Type([('sval', 's')])
+        A, B, C = [_Value(T, {'sval':S}) for S in ('aaaa', 'bbbb', 'cccc')]
+
+        _Value.internConfig(maxBytes=8)
+        try:
+            S0 = _Value.internStats()
+            a, b = A.sval, B.sval
+            self.assertIs(A.sval, a) # 'aaaa' now most recently used
+            c = C.sval # evicts 'bbbb'
+            S1 = _Value.internStats()
+            self.assertEqual(S1['evict']-S0['evict'], 1)
+            self.assertEqual(S1['strings'], 2)
+            self.assertLessEqual(S1['bytes'], 8)
+            self.assertIs(A.sval, a)
+            self.assertIs(C.sval, c)
+            self.assertIsNot(B.sval, b)
+        finally:
+            _Value.internConfig(maxBytes=1024*1024)
+
     def testSubStruct(self):
         V = _Value(_Type([
             ('ival', 'i'),
@@ -334,6 +536,57 @@ class TestRawValue(unittest.TestCase):
         self.assertFalse(A.changed('x'))
         self.assertFalse(A.changed('y'))
 
+        # only monitor updates carry overrun information
+        self.assertFalse(A.overrun())
+        self.assertFalse(A.overrun('x'))
+        self.assertRaises(KeyError, A.overrun, 'invalid')
+
+    def testBitSetCompare(self):
+        A = _Value(_Type([
+            ('x', 'i'),
+            ('d', 'd'),
+            ('s', 's'),
+            ('a', 'ad'),
+            ('b', 'as'),
+            ('z', ('S', None, [
+                ('a', 'i'),
+            ])),
+        ]), {
+            'x': 1,
+            'd': 1.5,
+            's': 'hello',
+            'a': [1, 2],
+            'b': ['x'],
+            'z': {'a': 3},
+        }, compare=True)
+
+        self.assertSetEqual(A.asSet(), set())
+
+        A.x = 1
+        A.d = 1.5
+        A.s = 'hello'
+        A.a = np.asfarray([1, 2])
+        A.a = np.asarray([1, 2], dtype='i4') # converted
+        A.b = ['x']
+        A.z.a = 3 # sub-structure inherits compare
+        self.assertSetEqual(A.asSet(), set())
+
+        A.x = 2
+        A.d = 2.5
+        A.s = 'world'
+        A.a = [1, 2, 3]
+        A.b = ['x', 'y']
+        A.z.a = 4
+        self.assertSetEqual(A.asSet(), {'x', 'd', 's', 'a', 'b', 'z.a'})
+        self.assertEqual(A.x, 2)
+        assert_aequal(A.a, [1, 2, 3])
+
+        # default always marks
+        B = _Value(A.type(), {'x': 2})
+        B.x = 2
+        B.a = []
+        self.assertSetEqual(B.asSet(), {'x', 'a'})
+
     def testBitSetRecurse(self):
         A= _Value(_Type([
             ('x', 'i'),
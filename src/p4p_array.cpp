@@ -1,6 +1,19 @@
 /* The P4PArray type exists only to act as the base object for a numpy array
  */
+#include <vector>
+#include <limits>
+
 #include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#ifdef _WIN32
+#  include <malloc.h>
+#endif
+#if defined(__linux__)
+#  include <sys/mman.h>
+#endif
 
 #include "p4p.h"
 
@@ -22,6 +35,403 @@ PyTypeObject P4PArray::type = {
     sizeof(P4PArray),
 };
 
+/* Pool of array buffers.
+ *
+ * Buffers are 64 byte aligned, and grouped in size classes, four for each
+ * power of 2, so that a buffer over 64 bytes is at most 25% larger than requested.
+ * When the last reference to an array is released, its buffer is returned
+ * to the free list of its class, up to a limit on the total number of bytes
+ * held in free lists.  Repeated updates with arrays of similar size
+ * will then re-use buffers instead of calling malloc()/free().
+ *
+ * Buffers may be released from any thread, so the pool has its own lock.
+ */
+struct BufferPool {
+    enum {
+        minShift = 6, // 64 bytes, also the alignment
+        maxShift = 28, // 256MB, larger are not pooled
+        stepShift = 2, // 4 classes for each power of 2
+        nStep = 1<<stepShift,
+        nClass = (maxShift-minShift)*nStep+1,
+    };
+
+    epicsMutex lock;
+    std::vector<void*> freelist[nClass];
+
+    // shared_ptr control blocks of pooled buffers.  See pool_ctrl_alloc
+    enum {
+        ctrlBytes = 128, // larger control blocks are not pooled
+        maxCtrl = 4096,
+    };
+    std::vector<void*> ctrlfree;
+
+    // bytes currently held in free lists
+    size_t cached;
+    // max. bytes to hold in free lists
+    size_t maxCached;
+    // madvise() buffers larger than this to use transparent huge pages.  zero disables
+    size_t hugeThreshold;
+
+    // statistics
+    size_t nAlloc,  // buffers allocated from the heap
+           nReuse,  // buffers taken from a free list
+           nReturn, // buffers returned to a free list
+           nFree;   // buffers returned to the heap
+
+    BufferPool() :cached(0u), maxCached(64u*1024u*1024u), hugeThreshold(0u)
+      ,nAlloc(0u), nReuse(0u), nReturn(0u), nFree(0u)
+    {}
+
+    // Class 0 is 64 bytes.  Then each (2**N, 2**(N+1)] is divided in nStep classes
+    static unsigned sizeClass(size_t nbytes) {
+        if(nbytes <= (size_t(1u)<<minShift))
+            return 0;
+        unsigned shift = minShift;
+        while(shift<maxShift && (size_t(2u)<<shift)<nbytes)
+            shift++;
+        if(shift==maxShift)
+            return nClass; // too large to pool
+        size_t step = size_t(1u)<<(shift-stepShift);
+        size_t k = (nbytes - (size_t(1u)<<shift) + step-1u)/step; // [1, nStep]
+        return unsigned((shift-minShift)*nStep + k);
+    }
+
+    static size_t classBytes(unsigned cls) {
+        if(cls==0)
+            return size_t(1u)<<minShift;
+        unsigned shift = minShift + (cls-1u)/nStep;
+        size_t k = (cls-1u)%nStep + 1u;
+        return (size_t(1u)<<shift) + k*(size_t(1u)<<(shift-stepShift));
+    }
+
+    // call w/o lock.  'hugeAt' is hugeThreshold
+    static void *heapAlloc(size_t nbytes, size_t hugeAt) {
+        size_t align = size_t(1u)<<minShift;
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+        bool huge = hugeAt && nbytes>=hugeAt;
+        if(huge)
+            align = 2u*1024u*1024u;
+#else
+        (void)hugeAt;
+#endif
+        void *ret = NULL;
+#ifdef _WIN32
+        ret = _aligned_malloc(nbytes, align);
+#else
+        if(posix_memalign(&ret, align, nbytes))
+            ret = NULL;
+#endif
+        if(!ret)
+            throw std::bad_alloc();
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+        if(huge)
+            (void)madvise(ret, nbytes, MADV_HUGEPAGE); // only a hint
+#endif
+        return ret;
+    }
+
+    static void heapFree(void *buf) {
+#ifdef _WIN32
+        _aligned_free(buf);
+#else
+        free(buf);
+#endif
+    }
+
+    void *take(unsigned cls, size_t nbytes) {
+        size_t hugeAt;
+        {
+            Guard G(lock);
+            if(cls<nClass && !freelist[cls].empty()) {
+                void *ret = freelist[cls].back();
+                freelist[cls].pop_back();
+                cached -= classBytes(cls);
+                nReuse++;
+                return ret;
+            }
+            nAlloc++;
+            hugeAt = hugeThreshold;
+        }
+        return heapAlloc(cls<nClass ? classBytes(cls) : nbytes, hugeAt);
+    }
+
+    void give(unsigned cls, void *buf) {
+        {
+            Guard G(lock);
+            if(cls<nClass && cached+classBytes(cls)<=maxCached) {
+                freelist[cls].push_back(buf);
+                cached += classBytes(cls);
+                nReturn++;
+                return;
+            }
+            nFree++;
+        }
+        heapFree(buf);
+    }
+
+    void *takeCtrl(size_t nbytes) {
+        if(nbytes<=ctrlBytes) {
+            {
+                Guard G(lock);
+                if(!ctrlfree.empty()) {
+                    void *ret = ctrlfree.back();
+                    ctrlfree.pop_back();
+                    return ret;
+                }
+            }
+            nbytes = ctrlBytes;
+        }
+        return ::operator new(nbytes);
+    }
+
+    void giveCtrl(void *buf, size_t nbytes) {
+        if(nbytes<=ctrlBytes) {
+            Guard G(lock);
+            if(ctrlfree.size()<maxCtrl) {
+                ctrlfree.push_back(buf);
+                return;
+            }
+        }
+        ::operator delete(buf);
+    }
+
+    // call with lock held.  Drop free buffers until under maxCached
+    void trim() {
+        for(unsigned cls=nClass; cls>0 && cached>maxCached; cls--) {
+            std::vector<void*>& L = freelist[cls-1];
+            while(!L.empty() && cached>maxCached) {
+                heapFree(L.back());
+                L.pop_back();
+                cached -= classBytes(cls-1);
+                nFree++;
+            }
+        }
+    }
+};
+
+// never free'd as buffers may be released during/after module cleanup
+BufferPool *pool;
+
+struct pool_free {
+    unsigned cls;
+    explicit pool_free(unsigned cls) :cls(cls) {}
+    void operator()(void *buf) {
+        pool->give(cls, buf);
+    }
+};
+
+#if __cplusplus>=201103L
+/* Allocates the shared_ptr control block of a pooled buffer from the pool,
+ * so that re-using a buffer doesn't allocate.
+ * tr1::shared_ptr before c++11 can't take an allocator.
+ */
+template<typename T>
+struct pool_ctrl_alloc {
+    typedef T value_type;
+    pool_ctrl_alloc() {}
+    template<typename U>
+    pool_ctrl_alloc(const pool_ctrl_alloc<U>&) {}
+    T* allocate(size_t n) { return static_cast<T*>(pool->takeCtrl(n*sizeof(T))); }
+    void deallocate(T* p, size_t n) { pool->giveCtrl(p, n*sizeof(T)); }
+};
+template<typename T, typename U>
+bool operator==(const pool_ctrl_alloc<T>&, const pool_ctrl_alloc<U>&) { return true; }
+template<typename T, typename U>
+bool operator!=(const pool_ctrl_alloc<T>&, const pool_ctrl_alloc<U>&) { return false; }
+#endif
+
+PyObject* P4PArray_poolStats(PyObject *junk)
+{
+    try {
+        size_t cached, maxCached, hugeThreshold, nAlloc, nReuse, nReturn, nFree;
+        {
+            Guard G(pool->lock);
+            cached = pool->cached;
+            maxCached = pool->maxCached;
+            hugeThreshold = pool->hugeThreshold;
+            nAlloc = pool->nAlloc;
+            nReuse = pool->nReuse;
+            nReturn = pool->nReturn;
+            nFree = pool->nFree;
+        }
+        return Py_BuildValue("{sKsKsKsKsKsKsK}",
+                             "cached", (unsigned long long)cached,
+                             "maxCached", (unsigned long long)maxCached,
+                             "hugeThreshold", (unsigned long long)hugeThreshold,
+                             "alloc", (unsigned long long)nAlloc,
+                             "reuse", (unsigned long long)nReuse,
+                             "return", (unsigned long long)nReturn,
+                             "free", (unsigned long long)nFree);
+    }CATCH()
+    return NULL;
+}
+
+PyObject* P4PArray_poolConfig(PyObject *junk, PyObject *args, PyObject *kws)
+{
+    try {
+        static const char* names[] = {"maxCached", "hugeThreshold", NULL};
+        PyObject *maxC = Py_None, *huge = Py_None;
+        if(!PyArg_ParseTupleAndKeywords(args, kws, "|OO", (char**)names, &maxC, &huge))
+            return NULL;
+
+        Py_ssize_t nmax = 0, nhuge = 0;
+        if(maxC!=Py_None) {
+            nmax = PyNumber_AsSsize_t(maxC, PyExc_OverflowError);
+            if(nmax==-1 && PyErr_Occurred())
+                return NULL;
+        }
+        if(huge!=Py_None) {
+            nhuge = PyNumber_AsSsize_t(huge, PyExc_OverflowError);
+            if(nhuge==-1 && PyErr_Occurred())
+                return NULL;
+        }
+        if(nmax<0 || nhuge<0) {
+            PyErr_SetString(PyExc_ValueError, "Limits must not be negative");
+            return NULL;
+        }
+
+        {
+            Guard G(pool->lock);
+            if(maxC!=Py_None) {
+                pool->maxCached = nmax;
+                pool->trim();
+            }
+            if(huge!=Py_None)
+                pool->hugeThreshold = nhuge;
+        }
+
+        Py_RETURN_NONE;
+    }CATCH()
+    return NULL;
+}
+
+static PyMethodDef P4PArray_methods[] = {
+    {"poolStats", (PyCFunction)&P4PArray_poolStats, METH_NOARGS|METH_STATIC,
+     "poolStats() -> {'cached':0, ...}\n\n"
+     "Statistics of the array buffer pool.\n"
+     "'alloc' and 'reuse' count buffers taken from the heap and from the pool.\n"
+     "'return' and 'free' count buffers given back to the pool and to the heap.\n"
+     "'cached' is the number of bytes currently held by the pool."},
+    {"poolConfig", (PyCFunction)&P4PArray_poolConfig, METH_VARARGS|METH_KEYWORDS|METH_STATIC,
+     "poolConfig(maxCached=None, hugeThreshold=None)\n\n"
+     "Change limit on bytes held by the array buffer pool.  Zero disables pooling.\n"
+     "Buffers of at least hugeThreshold bytes will use transparent huge pages (Linux only).\n"
+     "hugeThreshold=0 (the default) disables."},
+    {NULL}
+};
+
+/* Element conversion kernels.
+ *
+ * One tight loop for each (dest, src) pair of numeric types.
+ * Written so that the compiler can vectorize them (-O3):
+ * no per-element dispatch, and no branches in the loop body.
+ */
+template<typename D, typename S>
+struct elemcast {
+    static inline D op(S v) { return static_cast<D>(v); }
+};
+// numpy expects bool stored as 0 or 1
+template<typename S>
+struct elemcast<pvd::boolean, S> {
+    static inline pvd::boolean op(S v) { return v!=0; }
+};
+
+template<typename D, typename S>
+void convert_typed(void *dest, const void *src, size_t count)
+{
+    D *dst = static_cast<D*>(dest);
+    const S *s = static_cast<const S*>(src);
+    for(size_t i=0; i<count; i++)
+        dst[i] = elemcast<D, S>::op(s[i]);
+}
+
+typedef void (*convert_fn)(void *dest, const void *src, size_t count);
+
+template<typename D>
+convert_fn pick_src(pvd::ScalarType stype)
+{
+    switch(stype) {
+    case pvd::pvBoolean: return &convert_typed<D, pvd::boolean>;
+    case pvd::pvByte:    return &convert_typed<D, pvd::int8>;
+    case pvd::pvShort:   return &convert_typed<D, pvd::int16>;
+    case pvd::pvInt:     return &convert_typed<D, pvd::int32>;
+    case pvd::pvLong:    return &convert_typed<D, pvd::int64>;
+    case pvd::pvUByte:   return &convert_typed<D, pvd::uint8>;
+    case pvd::pvUShort:  return &convert_typed<D, pvd::uint16>;
+    case pvd::pvUInt:    return &convert_typed<D, pvd::uint32>;
+    case pvd::pvULong:   return &convert_typed<D, pvd::uint64>;
+    case pvd::pvFloat:   return &convert_typed<D, float>;
+    case pvd::pvDouble:  return &convert_typed<D, double>;
+    default:             return NULL;
+    }
+}
+
+/* Conversion of a floating point value to an integer is undefined
+ * for NaN, and for values whose integer part is out of range.
+ * Returns the index of the first such element, or 'count'.
+ */
+template<typename D, typename S>
+size_t find_unrepresentable(const void *src, size_t count)
+{
+    const S *s = static_cast<const S*>(src);
+    // 2**digits is one past the max. of D, and exact in S
+    const S hi = S(ldexp(1.0, std::numeric_limits<D>::digits));
+    const S lo = std::numeric_limits<D>::is_signed ? -hi : S(0);
+    for(size_t i=0; i<count; i++) {
+        S v = s[i];
+        // (lo-1, hi) truncates into range.  false for NaN
+        if(!(v<hi && (v>=lo || v>lo-S(1))))
+            return i;
+    }
+    return count;
+}
+
+typedef size_t (*check_fn)(const void *src, size_t count);
+
+template<typename S>
+check_fn pick_check_dest(pvd::ScalarType dtype)
+{
+    switch(dtype) {
+    case pvd::pvByte:    return &find_unrepresentable<pvd::int8, S>;
+    case pvd::pvShort:   return &find_unrepresentable<pvd::int16, S>;
+    case pvd::pvInt:     return &find_unrepresentable<pvd::int32, S>;
+    case pvd::pvLong:    return &find_unrepresentable<pvd::int64, S>;
+    case pvd::pvUByte:   return &find_unrepresentable<pvd::uint8, S>;
+    case pvd::pvUShort:  return &find_unrepresentable<pvd::uint16, S>;
+    case pvd::pvUInt:    return &find_unrepresentable<pvd::uint32, S>;
+    case pvd::pvULong:   return &find_unrepresentable<pvd::uint64, S>;
+    default:             return NULL; // boolean tests !=0, float and double are always defined
+    }
+}
+
+// NULL unless 'stype' to 'dtype' needs checking
+check_fn pick_check(pvd::ScalarType dtype, pvd::ScalarType stype)
+{
+    switch(stype) {
+    case pvd::pvFloat:   return pick_check_dest<float>(dtype);
+    case pvd::pvDouble:  return pick_check_dest<double>(dtype);
+    default:             return NULL;
+    }
+}
+
+convert_fn pick(pvd::ScalarType dtype, pvd::ScalarType stype)
+{
+    switch(dtype) {
+    case pvd::pvBoolean: return pick_src<pvd::boolean>(stype);
+    case pvd::pvByte:    return pick_src<pvd::int8>(stype);
+    case pvd::pvShort:   return pick_src<pvd::int16>(stype);
+    case pvd::pvInt:     return pick_src<pvd::int32>(stype);
+    case pvd::pvLong:    return pick_src<pvd::int64>(stype);
+    case pvd::pvUByte:   return pick_src<pvd::uint8>(stype);
+    case pvd::pvUShort:  return pick_src<pvd::uint16>(stype);
+    case pvd::pvUInt:    return pick_src<pvd::uint32>(stype);
+    case pvd::pvULong:   return pick_src<pvd::uint64>(stype);
+    case pvd::pvFloat:   return pick_src<float>(stype);
+    case pvd::pvDouble:  return pick_src<double>(stype);
+    default:             return NULL;
+    }
+}
+
 } // namespace
 
 PyTypeObject* P4PArray_type = &P4PArray::type;
@@ -41,6 +451,52 @@ const array_type& P4PArray_extract(PyObject* o)
     return P4PArray::unwrap(o);
 }
 
+pvd::shared_vector<void> P4PArray_alloc(pvd::ScalarType etype, size_t count)
+{
+    if(etype==pvd::pvString || count==0)
+        return pvd::ScalarTypeFunc::allocArray(etype, count);
+
+    size_t nbytes = count*pvd::ScalarTypeFunc::elementSize(etype);
+    unsigned cls = BufferPool::sizeClass(nbytes);
+
+#if __cplusplus>=201103L
+    std::tr1::shared_ptr<void> mem(pool->take(cls, nbytes), pool_free(cls), pool_ctrl_alloc<char>());
+#else
+    // control block from the heap
+    std::tr1::shared_ptr<void> mem(pool->take(cls, nbytes), pool_free(cls));
+#endif
+
+    pvd::shared_vector<void> ret(mem, 0, nbytes);
+    ret.set_original_type(etype);
+    return ret;
+}
+
+void P4PArray_convert(pvd::ScalarType dtype, void *dest,
+                      pvd::ScalarType stype, const void *src,
+                      size_t count)
+{
+    if(dtype==stype && dtype!=pvd::pvString) {
+        memcpy(dest, src, count*pvd::ScalarTypeFunc::elementSize(dtype));
+        return;
+    }
+    convert_fn fn = pick(dtype, stype);
+    if(!fn)
+        throw std::runtime_error(SB()<<"Unable to convert array from "<<pvd::ScalarTypeFunc::name(stype)
+                                 <<" to "<<pvd::ScalarTypeFunc::name(dtype));
+
+    // checked in a separate pass, to keep branches out of the conversion loop
+    check_fn chk = pick_check(dtype, stype);
+    size_t bad = chk ? (*chk)(src, count) : count;
+    if(bad<count) {
+        double v = stype==pvd::pvFloat ? static_cast<const float*>(src)[bad] : static_cast<const double*>(src)[bad];
+        PyErr_SetString(PyExc_ValueError, std::string(SB()<<"Element "<<bad<<" ("<<v<<") can't be converted to "
+                                                      <<pvd::ScalarTypeFunc::name(dtype)).c_str());
+        throw std::runtime_error("out of range");
+    }
+
+    (*fn)(dest, src, count);
+}
+
 void p4p_array_register(PyObject *mod)
 {
     P4PArray::type.tp_flags = Py_TPFLAGS_DEFAULT|Py_TPFLAGS_BASETYPE;
@@ -50,6 +506,10 @@ void p4p_array_register(PyObject *mod)
     //P4PArray::type.tp_weaklistoffset = offsetof()
 
     P4PArray::type.tp_doc = "Holder for a shared_array<> being shared w/ numpy";
+    P4PArray::type.tp_methods = P4PArray_methods;
+
+    if(!pool)
+        pool = new BufferPool;
 
     if(PyType_Ready(&P4PArray::type))
         throw std::runtime_error("failed to initialize P4PArray_type");
@@ -2,14 +2,30 @@
 #include <map>
 #include <set>
 #include <list>
+#include <deque>
+#include <vector>
 #include <iostream>
 #include <typeinfo>
 
 #include <stdlib.h>
+#include <errno.h>
+
+#if defined(__linux__)
+#  include <unistd.h>
+#  include <sys/eventfd.h>
+#elif !defined(_WIN32)
+#  include <unistd.h>
+#  include <fcntl.h>
+#endif
 
 #include <epicsMutex.h>
 #include <epicsGuard.h>
+#include <epicsTime.h>
+#include <epicsEvent.h>
+#include <epicsThread.h>
+#include <epicsTimer.h>
 
+#include <pv/convert.h>
 #include <pv/pvAccess.h>
 #include <pv/logger.h>
 #include <pv/clientFactory.h>
@@ -25,14 +41,94 @@ typedef epicsGuard<epicsMutex> Guard;
 namespace pvd = epics::pvData;
 namespace pva = epics::pvAccess;
 
+// p4p._p4p.TimeoutError
+PyObject *P4PTimeout;
+
 struct Context;
 struct Channel;
+struct ChannelPool;
+struct CopyPlan;
 struct OpBase;
+struct MonitorOp;
+struct GetterOp;
+struct PutterOp;
+struct Deadline;
+struct BulkWait;
+
+// Runs operation callbacks on worker threads, so that PVA threads only queue work,
+// and never wait for the GIL, or for user code.
+// Each worker takes the GIL once for all of the work queued since it last woke.
+// When 'ordered', work with the same key (a Channel) always goes to the same worker,
+// so the callbacks of one Channel are made in the order queued.
+struct Dispatcher {
+    POINTER_DEFINITIONS(Dispatcher);
+
+    struct Work {
+        POINTER_DEFINITIONS(Work);
+        virtual ~Work() {}
+        // called with GIL
+        virtual void run() =0;
+    };
+
+    // Kept alive by its thread, which exits once stopped and the queue is empty
+    struct Worker {
+        POINTER_DEFINITIONS(Worker);
+
+        epicsMutex lock;
+        epicsEvent wakeup, exited;
+        epicsThreadId id;
+        // guarded by lock
+        std::deque<Work::shared_pointer> queue;
+        bool running;
+        size_t maxdepth;
+
+        Worker() :id(0), running(true), maxdepth(0) {}
+
+        // false if stopped
+        bool push(const Work::shared_pointer& work);
+
+        static void run(void *raw);
+    };
+
+    epicsMutex lock;
+    // guarded by lock
+    // threads are started by the first push()
+    std::vector<Worker::shared_pointer> workers;
+    size_t nworkers, next;
+    bool ordered, running;
+
+    Dispatcher() :nworkers(1u), next(0u), ordered(true), running(true) {}
+    // Workers run any work already queued, then exit.  Don't wait here as the GIL may be held.
+    ~Dispatcher() { stop(false); }
+
+    // queue work.  key 0 for any worker.  false if stopped.  call from any thread
+    bool push(size_t key, const Work::shared_pointer& work);
+    // stop workers after they run any work already queued.
+    // wait for all but the calling thread.  call w/o GIL
+    void stop(bool wait=true);
+    // is the calling thread one of our workers
+    bool isWorker();
+
+    // run, and report any exception.  call with GIL
+    static void call(Work& work);
+
+    static int       py_init(PyObject *self, PyObject *args, PyObject *kws);
+    static PyObject *py_push(PyObject *self, PyObject *args, PyObject *kws);
+    static PyObject *py_sync(PyObject *self);
+    static PyObject *py_close(PyObject *self);
+    static PyObject *py_stats(PyObject *self);
+};
 
 struct Context {
     POINTER_DEFINITIONS(Context);
 
     pva::ChannelProvider::shared_pointer provider;
+    std::tr1::shared_ptr<ChannelPool> pool;
+    // callbacks of new Channels are run here, if set
+    Dispatcher::shared_pointer dispatch;
+    // handles held by connect_many(keep=) until a time, so not idle.  guarded by GIL
+    typedef std::multimap<epicsTime, std::tr1::shared_ptr<Channel> > pins_t;
+    pins_t pins;
 
     char *name;
 
@@ -41,9 +137,19 @@ struct Context {
 
     void close();
 
+    // handle to a (possibly new) Channel from the pool.  call with GIL
+    std::tr1::shared_ptr<Channel> getChannel(const std::string& name, short prio);
+    // handles to many Channels.  New Channels are created with the GIL released once.  call with GIL
+    void getChannels(const std::vector<std::string>& names, short prio, std::vector<std::tr1::shared_ptr<Channel> >& chans);
+
     static int       py_init(PyObject *self, PyObject *args, PyObject *kws);
     static PyObject *py_channel(PyObject *self, PyObject *args, PyObject *kws);
     static PyObject *py_close(PyObject *self);
+    static PyObject *py_poolStats(PyObject *self);
+    static PyObject *py_get_many(PyObject *self, PyObject *args, PyObject *kws);
+    static PyObject *py_put_many(PyObject *self, PyObject *args, PyObject *kws);
+    static PyObject *py_rpc_many(PyObject *self, PyObject *args, PyObject *kws);
+    static PyObject *py_connect_many(PyObject *self, PyObject *args, PyObject *kws);
 
     static PyObject *py_providers(PyObject *junk);
     static PyObject *py_set_debug(PyObject *junk, PyObject *args, PyObject *kws);
@@ -67,15 +173,53 @@ struct Channel {
     };
 
     pva::Channel::shared_pointer channel;
+    // from the Context.  set before connecting
+    Dispatcher::shared_pointer dispatch;
+
+    // guards ops, and the connection state below.
+    // May be locked with the GIL held, but the GIL is never locked while holding this.
+    epicsMutex lock;
+    // from getField(), for the current connection.  guarded by lock
+    pvd::StructureConstPtr fieldType;
+    // incremented on each connect, disconnect, and destroy.  guarded by lock
+    unsigned connGen;
+    // connGen when 'ops' were last restart()ed, lostConn()ed or cancel()ed.  guarded by lock
+    unsigned opsGen;
+    // as of the last channelStateChange().  guarded by lock
+    bool connected;
+    // finish()'d on the next connect.  guarded by lock
+    typedef std::vector<std::pair<std::tr1::shared_ptr<BulkWait>, size_t> > waiters_t;
+    waiters_t waiters;
+
+    Channel() :connGen(0), opsGen(0), connected(false), plans(8u) {}
 
     struct Op {
         POINTER_DEFINITIONS(Op);
         Channel::shared_pointer channel;
-        Op(const Channel::shared_pointer& ch) :channel(ch) {}
+        // copied from the Channel, as 'channel' is reset by cancel()
+        const Dispatcher::shared_pointer dispatch;
+        const size_t dispatchKey;
+        // set when a timeout was given.  guarded by GIL
+        Deadline *deadline;
+        Op(const Channel::shared_pointer& ch) :channel(ch), dispatch(ch->dispatch), dispatchKey(size_t(ch.get())), deadline(0) {}
         virtual ~Op() {
             PyLock L;
             cancel();
         }
+        // run with GIL.  Through the Dispatcher if any, otherwise before returning.
+        // call w/o GIL, from a PVA callback
+        void defer(const Dispatcher::Work::shared_pointer& work) const {
+            if(dispatch && dispatch->push(dispatchKey, work))
+                return;
+            PyLock L;
+            Dispatcher::call(*work);
+        }
+        // expire() after 'timeout' seconds, unless cleared first.  call with GIL
+        void setDeadline(const Op::shared_pointer& self, double timeout);
+        // stop the timer, if any.  call with GIL
+        void clearDeadline();
+        // timeout before completion.  call with GIL
+        virtual void expire() {}
         // pva::Channel life-cycle callbacks
         //  called to (re)start operation
         virtual void restart(const Op::shared_pointer& self) =0;
@@ -84,15 +228,19 @@ struct Channel {
         //  channel destoryed or user cancel
         virtual bool cancel() {
             TRACE("chan="<<channel.get()<<" "<<typeid(this).name());
+            clearDeadline();
             if(!channel) return false;
             bool found = false;
-            for(Channel::operations_t::iterator it = channel->ops.begin(), end = channel->ops.end(); it!=end; ++it)
             {
-                if(it->get()==this) {
-                    found = true;
-                    TRACE("remove "<<it->use_count());
-                    channel->ops.erase(it);
-                    break;
+                Guard G(channel->lock);
+                for(Channel::operations_t::iterator it = channel->ops.begin(), end = channel->ops.end(); it!=end; ++it)
+                {
+                    if(it->get()==this) {
+                        found = true;
+                        TRACE("remove "<<it->use_count());
+                        channel->ops.erase(it);
+                        break;
+                    }
                 }
             }
             channel.reset();
@@ -100,16 +248,346 @@ struct Channel {
         }
     };
 
+    // Operations waiting for a connection, or to be notified of a disconnect.  guarded by lock
     typedef std::set<Op::shared_pointer> operations_t;
     operations_t ops;
 
+    // (re)add to ops.  call from restart() and lostConn()
+    void track(const Op::shared_pointer& op) {
+        Guard G(lock);
+        ops.insert(op);
+    }
+    // restart() a new operation now if connected, otherwise once connected.  call with GIL
+    void start(const Op::shared_pointer& op);
+    // restart(), lostConn(), or cancel() ops, unless a later state change is pending.  call with GIL
+    void stateChanged(unsigned gen, pva::Channel::ConnectionState state);
+
+    // put conversions by (client, server) type.  guarded by GIL
+    // The server type only changes on reconnect, and a PV is usually put with one,
+    // or a few, types of Value.  So a few entries suffice, and the least recently used
+    // are those of a previous connection.
+    typedef LRUCache<std::pair<const pvd::Structure*, const pvd::Structure*>, std::tr1::shared_ptr<const CopyPlan> > plans_t;
+    plans_t plans;
+
+    // find, or build, a conversion.  call with GIL
+    std::tr1::shared_ptr<const CopyPlan> plan(const pvd::StructureConstPtr& src, const pvd::StructureConstPtr& dest);
+
     static int py_init(PyObject *self, PyObject *args, PyObject *kws);
     static PyObject *py_get(PyObject *self, PyObject *args, PyObject *kws);
     static PyObject *py_put(PyObject *self, PyObject *args, PyObject *kws);
     static PyObject *py_rpc(PyObject *self, PyObject *args, PyObject *kws);
     static PyObject *py_monitor(PyObject *self, PyObject *args, PyObject *kws);
+    static PyObject *py_getter(PyObject *self, PyObject *args, PyObject *kws);
+    static PyObject *py_putter(PyObject *self, PyObject *args, PyObject *kws);
+    static PyObject *py_type(PyObject *self, PyObject *args, PyObject *kws);
     static PyObject *py_name(PyObject *self);
     static PyObject *py_close(PyObject *self);
+    static PyObject *py_convert(PyObject *self, PyObject *args, PyObject *kws);
+};
+
+// Copies between PVStructures of different types, matching fields by name,
+// and converting scalar and array fields.
+// Other fields are copied only if their types are the same.
+struct CopyPlan {
+    // keeps the types alive, so cache keys are not re-used
+    pvd::StructureConstPtr src, dest;
+
+    struct Step {
+        // offsets relative to the top structure
+        size_t soff, doff;
+        pvd::Type kind;
+    };
+    std::vector<Step> steps;
+    // source fields with no match
+    std::vector<size_t> unmatched;
+
+    CopyPlan(const pvd::StructureConstPtr& src, const pvd::StructureConstPtr& dest)
+        :src(src), dest(dest)
+    {
+        // the only way to find offsets is from an instance
+        pvd::PVStructurePtr S(pvd::getPVDataCreate()->createPVStructure(src)),
+                            D(pvd::getPVDataCreate()->createPVStructure(dest));
+        build(*S, *D);
+    }
+
+    // Copy fields of 'S' which are marked in 'smask' (all if NULL or bit 0 set) into 'D'.
+    // Marks the fields copied in 'dmask'.
+    // Throws if a field to be copied has no match, or if nothing would be copied.
+    void apply(const pvd::PVStructurePtr& S, const pvd::BitSet *smask,
+               const pvd::PVStructurePtr& D, pvd::BitSet& dmask) const
+    {
+        if(smask && smask->get(0))
+            smask = 0;
+
+        const size_t sbase = S->getFieldOffset(), dbase = D->getFieldOffset();
+
+        for(size_t i=0; i<unmatched.size(); i++) {
+            pvd::PVField *fld = S->getSubFieldT(sbase+unmatched[i]).get();
+            if(!smask || marked(fld, *smask))
+                throw std::runtime_error(SB()<<"PV has no field "<<fld->getFullName());
+        }
+
+        size_t ncopied = 0u;
+        for(size_t i=0; i<steps.size(); i++) {
+            const Step& step = steps[i];
+            pvd::PVFieldPtr sfld(S->getSubFieldT(sbase+step.soff)),
+                            dfld(D->getSubFieldT(dbase+step.doff));
+            if(smask && !marked(sfld.get(), *smask))
+                continue;
+
+            switch(step.kind) {
+            case pvd::scalar:
+                static_cast<pvd::PVScalar*>(dfld.get())->assign(*static_cast<pvd::PVScalar*>(sfld.get()));
+                break;
+            case pvd::scalarArray:
+                static_cast<pvd::PVScalarArray*>(dfld.get())->assign(*static_cast<pvd::PVScalarArray*>(sfld.get()));
+                break;
+            default:
+                pvd::getConvert()->copy(sfld, dfld);
+                break;
+            }
+            dmask.set(dfld->getFieldOffset());
+            ncopied++;
+        }
+
+        // an empty put would be reported as success.  Unless nothing was marked to begin with.
+        if(ncopied==0u && (!smask || smask->nextSetBit(0)>=0))
+            throw std::runtime_error("No field of the put value matches a field of the PV");
+    }
+
+private:
+    void build(pvd::PVStructure& S, pvd::PVStructure& D)
+    {
+        const pvd::PVFieldPtrArray& sflds(S.getPVFields());
+        for(size_t i=0; i<sflds.size(); i++) {
+            pvd::PVField *sfld = sflds[i].get();
+            pvd::PVFieldPtr dfld(D.getSubField(sfld->getFieldName()));
+            if(!dfld) {
+                unmatched.push_back(sfld->getFieldOffset());
+                continue;
+            }
+            pvd::Type stype = sfld->getField()->getType(),
+                      dtype = dfld->getField()->getType();
+
+            if(stype==pvd::structure && dtype==pvd::structure) {
+                build(static_cast<pvd::PVStructure&>(*sfld), static_cast<pvd::PVStructure&>(*dfld));
+                continue;
+
+            } else if(stype!=dtype || (stype!=pvd::scalar && stype!=pvd::scalarArray
+                                       && !(*sfld->getField()==*dfld->getField()))) {
+                throw std::runtime_error(SB()<<"Can't convert field "<<sfld->getFullName()<<" to type of PV");
+            }
+
+            Step step = {sfld->getFieldOffset(), dfld->getFieldOffset(), stype};
+            steps.push_back(step);
+        }
+    }
+
+    // is this field, or a parent, marked
+    static bool marked(pvd::PVField *fld, const pvd::BitSet& mask)
+    {
+        for(; fld; fld = fld->getParent()) {
+            if(mask.get(fld->getFieldOffset()))
+                return true;
+        }
+        return false;
+    }
+};
+
+std::tr1::shared_ptr<const CopyPlan> Channel::plan(const pvd::StructureConstPtr& src, const pvd::StructureConstPtr& dest)
+{
+    std::pair<const pvd::Structure*, const pvd::Structure*> key(src.get(), dest.get());
+    std::tr1::shared_ptr<const CopyPlan> *ent = plans.find(key);
+    if(ent)
+        return *ent;
+
+    return plans.insert(key, std::tr1::shared_ptr<const CopyPlan>(new CopyPlan(src, dest)));
+}
+
+// Channels of a Context by (name, priority).
+// Python Channel objects, and operations, hold a handle to a Channel from the pool.
+// When the last handle is released, the Channel is kept for re-use,
+// until it has been unused for maxAge seconds, or there are more than maxIdle unused Channels.
+struct ChannelPool {
+    POINTER_DEFINITIONS(ChannelPool);
+
+    typedef std::pair<std::string, short> key_type;
+    typedef std::list<key_type> idle_t;
+
+    struct Entry {
+        Channel::shared_pointer chan;
+        // # of handles
+        size_t users;
+        // when users==0
+        idle_t::iterator idlepos;
+        epicsTime idleSince;
+        Entry() :users(0) {}
+    };
+    typedef std::map<key_type, Entry> entries_t;
+
+    epicsMutex lock;
+    // guarded by lock
+    entries_t entries;
+    idle_t idle; // oldest first
+    double maxAge; // <0 keep forever
+    size_t maxIdle;
+
+    ChannelPool() :maxAge(30.0), maxIdle(1024u) {}
+
+    // Deleter of handles.  Keeps the Channel alive while any handle exists,
+    // even if removed from the pool.
+    struct Use {
+        ChannelPool::weak_pointer pool;
+        key_type key;
+        Channel::shared_pointer chan;
+        Use(const ChannelPool::shared_pointer& pool, const key_type& key, const Channel::shared_pointer& chan)
+            :pool(pool), key(key), chan(chan) {}
+        void operator()(Channel*) {
+            ChannelPool::shared_pointer P(pool.lock());
+            if(P)
+                P->release(key, chan);
+        }
+    };
+
+    // new handle to an existing Channel, or NULL
+    static Channel::shared_pointer acquire(const ChannelPool::shared_pointer& self, const key_type& key)
+    {
+        Channel::shared_pointer chan;
+        {
+            Guard G(self->lock);
+            entries_t::iterator it(self->entries.find(key));
+            if(it==self->entries.end() || !it->second.chan->channel)
+                return chan;
+            Entry& ent = it->second;
+            if(ent.users++==0)
+                self->idle.erase(ent.idlepos);
+            chan = ent.chan;
+        }
+        return Channel::shared_pointer(chan.get(), Use(self, key, chan));
+    }
+
+    // add a new Channel.  returns the first handle
+    static Channel::shared_pointer add(const ChannelPool::shared_pointer& self, const key_type& key, const Channel::shared_pointer& chan)
+    {
+        {
+            Guard G(self->lock);
+            Entry& ent = self->entries[key];
+            if(ent.chan && ent.users==0)
+                self->idle.erase(ent.idlepos);
+            // any previous Channel is kept alive by its handles
+            ent.chan = chan;
+            ent.users = 1;
+        }
+        return Channel::shared_pointer(chan.get(), Use(self, key, chan));
+    }
+
+    void release(const key_type& key, const Channel::shared_pointer& chan)
+    {
+        Guard G(lock);
+        entries_t::iterator it(entries.find(key));
+        if(it==entries.end() || it->second.chan!=chan)
+            return; // replaced or removed
+        Entry& ent = it->second;
+        if(--ent.users==0) {
+            ent.idlepos = idle.insert(idle.end(), key);
+            ent.idleSince = epicsTime::getCurrent();
+        }
+    }
+
+    // remove Channels unused for too long, or in excess of maxIdle.
+    void expire(std::vector<Channel::shared_pointer>& trash)
+    {
+        Guard G(lock);
+        epicsTime now(epicsTime::getCurrent());
+        while(!idle.empty()) {
+            entries_t::iterator it(entries.find(idle.front()));
+            assert(it!=entries.end());
+            if(idle.size()<=maxIdle && (maxAge<0.0 || now - it->second.idleSince < maxAge))
+                break;
+            trash.push_back(it->second.chan);
+            idle.pop_front();
+            entries.erase(it);
+        }
+    }
+
+    void clear(std::vector<Channel::shared_pointer>& trash)
+    {
+        Guard G(lock);
+        for(entries_t::iterator it(entries.begin()), end(entries.end()); it!=end; ++it)
+            trash.push_back(it->second.chan);
+        entries.clear();
+        idle.clear();
+    }
+};
+
+// destroy() removed Channels.  call with GIL
+void destroy_channels(std::vector<Channel::shared_pointer>& trash)
+{
+    if(trash.empty())
+        return;
+    std::vector<pva::Channel::shared_pointer> chans(trash.size());
+    for(size_t i=0; i<trash.size(); i++)
+        trash[i]->channel.swap(chans[i]);
+    trash.clear();
+    {
+        PyUnlock U;
+        for(size_t i=0; i<chans.size(); i++) {
+            if(chans[i])
+                chans[i]->destroy();
+        }
+        chans.clear();
+    }
+}
+
+// Collects the results of a group of operations,
+// so that completion may be waited for without the GIL.
+struct BulkWait {
+    POINTER_DEFINITIONS(BulkWait);
+
+    epicsMutex lock;
+    epicsEvent done;
+
+    // guarded by lock
+    size_t remaining;
+    std::vector<bool> complete;
+    std::vector<pvd::PVStructure::shared_pointer> values;
+    std::vector<std::string> errors; // non-empty on error
+    // guarded by lock and GIL.
+    // completion with a python object (eg. exception from a put value builder)
+    std::vector<PyRef> pyresults;
+
+    explicit BulkWait(size_t N) :remaining(N), complete(N, false), values(N), errors(N), pyresults(N) {}
+
+    // call w/o GIL
+    void finish(size_t i, const pvd::Status& sts, const pvd::PVStructure::shared_pointer& val)
+    {
+        Guard G(lock);
+        if(complete[i])
+            return;
+        if(sts.isSuccess())
+            values[i] = val;
+        else
+            errors[i] = sts.getMessage().empty() ? std::string("Error") : sts.getMessage();
+        mark(i);
+    }
+
+    // call with GIL
+    void finish(size_t i, PyObject *obj)
+    {
+        Guard G(lock);
+        if(complete[i])
+            return;
+        pyresults[i].reset(obj, borrow());
+        mark(i);
+    }
+
+private:
+    void mark(size_t i)
+    {
+        complete[i] = true;
+        if(--remaining==0)
+            done.signal();
+    }
 };
 
 // base for one-shot operations
@@ -123,11 +601,26 @@ struct OpBase : public Channel::Op {
     PyRef pyvalue;
     // rpc value
     pvd::PVStructure::shared_pointer pvvalue;
+    // when set, completion is reported here instead of through 'cb'.
+    // set before the operation is started.
+    BulkWait::shared_pointer bulk;
+    size_t bulkIndex;
 
-    OpBase(const Channel::shared_pointer& ch) :Channel::Op(ch) {}
+    OpBase(const Channel::shared_pointer& ch) :Channel::Op(ch), bulkIndex(0) {}
     virtual ~OpBase() {}
 
+    // report completion to 'bulk', or through 'cb'.  call w/o GIL
+    static void complete(const OpBase::shared_pointer& op, const pvd::Status& sts,
+                         const pvd::PVStructure::shared_pointer& val = pvd::PVStructure::shared_pointer());
+    // call 'cb' with an Exception, the Value, or None.  call with GIL
+    void done(const pvd::Status& sts, const pvd::PVStructure::shared_pointer& val);
+
     void call_cb(PyObject *obj) {
+        if(bulk) {
+            bulk->finish(bulkIndex, obj);
+            return;
+        }
+        clearDeadline();
         PyRef temp;
         cb.swap(temp);
         if(!temp.get()) return;
@@ -146,6 +639,8 @@ struct OpBase : public Channel::Op {
         return ret;
     }
 
+    virtual void expire();
+
     // called with GIL locked
     void destroy() { cancel(); }
 
@@ -154,9 +649,62 @@ struct OpBase : public Channel::Op {
     static int py_clear(PyObject *self);
 };
 
+// Collects Subscriptions with pending updates, and signals a file descriptor
+// which may be given to select()/poll().
+struct Selector {
+    POINTER_DEFINITIONS(Selector);
+
+    epicsMutex lock;
+    // guarded by lock
+    // Subscriptions notified since the last ready()
+    std::vector<std::tr1::weak_ptr<MonitorOp> > pending;
+    // is rfd readable
+    bool signaled;
+    // -1 when closed.  Equal w/ eventfd()
+    int rfd, wfd;
+
+    // guarded by GIL
+    // Subscription objects add()'d
+    typedef std::map<MonitorOp*, PyRef> subs_t;
+    subs_t subs;
+
+    Selector();
+    ~Selector() { close(); }
+
+    // call w/o GIL, from any thread
+    void post(const std::tr1::shared_ptr<MonitorOp>& op);
+
+    void close();
+
+    static int       py_init(PyObject *self, PyObject *args, PyObject *kws);
+    static PyObject *py_fileno(PyObject *self);
+    static PyObject *py_add(PyObject *self, PyObject *args);
+    static PyObject *py_remove(PyObject *self, PyObject *args);
+    static PyObject *py_ready(PyObject *self);
+    static PyObject *py_close(PyObject *self);
+
+    static int py_traverse(PyObject *self, visitproc visit, void *arg);
+    static int py_clear(PyObject *self);
+};
+
 struct MonitorOp : Channel::Op {
     POINTER_DEFINITIONS(MonitorOp);
 
+    // a callback from the Monitor, handled with GIL
+    struct Event : public Dispatcher::Work {
+        enum kind_t {Connect, Update, Unlisten} kind;
+        MonitorOp::shared_pointer op;
+        pvd::Status status;
+        pvd::MonitorPtr monitor;
+        pvd::StructureConstPtr type;
+        Event(kind_t kind, const MonitorOp::shared_pointer& op,
+              const pvd::Status& status = pvd::Status(), const pvd::MonitorPtr& monitor = pvd::MonitorPtr(),
+              const pvd::StructureConstPtr& type = pvd::StructureConstPtr())
+            :kind(kind), op(op), status(status), monitor(monitor), type(type) {}
+        virtual ~Event() {}
+        virtual void run();
+    };
+
     struct Req : public pva::MonitorRequester {
         POINTER_DEFINITIONS(Req);
 
@@ -173,22 +721,7 @@ struct MonitorOp : Channel::Op {
             MonitorOp::shared_pointer op(owner);
             if(!op)
                 return;
-            PyLock L;
-            if(op->done)
-                return;
-            if(status.isSuccess()) {
-                monitor->start();
-                TRACE("start() "<<op->event.get());
-            }
-
-            if(!status.isSuccess()) {
-                PyRef err(PyObject_CallFunction(PyExc_RuntimeError, "s", status.getMessage().c_str()));
-                op->call_cb(err.get());
-                op->event.reset();
-                TRACE("error");
-            } else {
-                op->empty = true;
-            }
+            op->defer(Dispatcher::Work::shared_pointer(new Event(Event::Connect, op, status, monitor, structure)));
         }
 
         virtual void monitorEvent(pvd::MonitorPtr const & monitor)
@@ -197,10 +730,21 @@ struct MonitorOp : Channel::Op {
             MonitorOp::shared_pointer op(owner);
             if(!op)
                 return;
-            PyLock L;
-            op->empty = false;
-            PyRef val(Py_None, borrow());
-            op->call_cb(val.get());
+            Selector::shared_pointer sel;
+            {
+                // only notify when the queue may have become non-empty.
+                // Skip the GIL until the consumer drains the queue
+                Guard G(op->lock);
+                if(op->notified)
+                    return;
+                op->notified = true;
+                sel = op->selector;
+            }
+            if(sel) {
+                sel->post(op);
+                return;
+            }
+            op->defer(Dispatcher::Work::shared_pointer(new Event(Event::Update, op)));
             TRACE("notified");
         }
 
@@ -210,33 +754,111 @@ struct MonitorOp : Channel::Op {
             MonitorOp::shared_pointer op(owner);
             if(!op)
                 return;
-            PyLock L;
-            op->done = true;
-            PyRef val(Py_None, borrow());
-            op->call_cb(val.get());
+            op->defer(Dispatcher::Work::shared_pointer(new Event(Event::Unlisten, op)));
+        }
+    };
+
+    // Held by a Value which borrows a MonitorElement.
+    // Returns the element to the Monitor when the last such Value is collected.
+    struct ElementPin {
+        pva::Monitor::shared_pointer mon;
+        pva::MonitorElementPtr elem;
+        ElementPin(const pva::Monitor::shared_pointer& mon, const pva::MonitorElementPtr& elem)
+            :mon(mon), elem(elem) {}
+        ~ElementPin() {
+            mon->release(elem);
         }
     };
 
-    MonitorOp(const Channel::shared_pointer& ch) :Channel::Op(ch), empty(true), done(false) {}
+    MonitorOp(const Channel::shared_pointer& ch) :Channel::Op(ch), empty(true), done(false), borrow(false), nUpdates(0), nOverruns(0), depth(0), maxDepth(0), notified(false) {}
     ~MonitorOp() {
         // TODO: call_cb() w/ done?
     }
 
     pva::Monitor::shared_pointer op;
     pvd::PVStructure::shared_pointer pvReq;
+    // type of updates, from the last successful connect.  NULL until then
+    pvd::StructureConstPtr type;
+    // polled from 'op', but not yet consumed.  Returned first by the next poll()
+    pva::MonitorElementPtr held;
 
     // error/non-empty callback
     PyRef event;
     bool empty, done;
+    // pop() returns Values referencing MonitorElements instead of copies
+    bool borrow;
+    // updates popped, and how many of those had overrun fields
+    size_t nUpdates, nOverruns;
+    // updates popped since the queue was last found empty, ie. the queue depth when first polled.
+    // and the high-water mark of this
+    size_t depth, maxDepth;
+
+    epicsMutex lock;
+    // guarded by lock.
+    // set when monitorEvent() has called 'event', until poll() finds the queue empty
+    bool notified;
+    // when set, notify through this instead of 'event'
+    Selector::shared_pointer selector;
+
+    // poll() the Monitor.  When empty, re-arm the notification from monitorEvent()
+    pva::MonitorElementPtr poll() {
+        if(held) {
+            // already counted in depth
+            pva::MonitorElementPtr elem;
+            elem.swap(held);
+            return elem;
+        }
+        pva::MonitorElementPtr elem(op->poll());
+        if(!elem) {
+            {
+                Guard G(lock);
+                notified = false;
+            }
+            // an update may have been queued while still notified
+            elem = op->poll();
+            if(elem) {
+                Guard G(lock);
+                notified = true;
+            }
+        }
+        if(!elem) {
+            depth = 0u;
+        } else if(maxDepth < ++depth) {
+            maxDepth = depth;
+        }
+        return elem;
+    }
 
-    void call_cb(PyObject *obj) {
-        if(!event.get()) return;
+    // return 'held' to 'mon', which it was polled from
+    void releaseHeld(const pva::Monitor::shared_pointer& mon) {
+        if(held && mon)
+            mon->release(held);
+        held.reset();
+    }
+
+    // count, and copy of overrunBitSet, or NULL if none
+    pvd::BitSet::shared_pointer account(const pva::MonitorElementPtr& elem) {
+        nUpdates++;
+        pvd::BitSet::shared_pointer O;
+        if(elem->overrunBitSet && !elem->overrunBitSet->isEmpty()) {
+            nOverruns++;
+            O.reset(new pvd::BitSet);
+            *O = *elem->overrunBitSet;
+        }
+        return O;
+    }
+
+    // returns false if 'event' is not set, or raised
+    bool call_cb(PyObject *obj) {
+        if(!event.get()) return false;
         PyObject *junk = PyObject_CallFunctionObjArgs(event.get(), obj, NULL);
         if(junk) {
             Py_DECREF(junk);
+            return true;
         } else {
             PyErr_Print();
             PyErr_Clear();
+            return false;
         }
     }
 
@@ -246,22 +868,28 @@ struct MonitorOp : Channel::Op {
         if(!channel || done) return;
         Req::shared_pointer req(new Req(std::tr1::static_pointer_cast<MonitorOp>(self)));
         pva::Monitor::shared_pointer mon;
+        {
+            Guard G(lock);
+            notified = false;
+        }
+        releaseHeld(op);
         {
             PyUnlock U;
 
             mon = channel->channel->createMonitor(req, pvReq);
         }
         op.swap(mon);
-        channel->ops.insert(self);
+        channel->track(self);
     }
 
     virtual void lostConn(const Op::shared_pointer& self)
     {
         TRACE("done="<<done);
         if(channel && !done)
-            channel->ops.insert(self);
+            channel->track(self);
         pva::Monitor::shared_pointer mon;
         op.swap(mon);
+        releaseHeld(mon);
         if(mon) {
             PyUnlock U;
 
@@ -271,11 +899,14 @@ struct MonitorOp : Channel::Op {
         }
     }
 
+    virtual void expire();
+
     virtual bool cancel() {
         TRACE("cancel");
         bool ret = Channel::Op::cancel();
         event.release();
         done = true;
+        releaseHeld(op);
         if(op) {
             op->stop();
             op->destroy();
@@ -284,10 +915,16 @@ struct MonitorOp : Channel::Op {
         return ret;
     }
 
+    // pop one update as a Value.  NULL (w/o exception) when empty
+    PyObject *pop();
+
     static PyObject *py_close(PyObject *self);
     static PyObject *py_empty(PyObject *self);
     static PyObject *py_done(PyObject *self);
     static PyObject *py_pop(PyObject *self);
+    static PyObject *py_pop_many(PyObject *self, PyObject *args, PyObject *kws);
+    static PyObject *py_pop_columns(PyObject *self, PyObject *args, PyObject *kws);
+    static PyObject *py_stats(PyObject *self);
 
     static int py_traverse(PyObject *self, visitproc visit, void *arg);
     static int py_clear(PyObject *self);
@@ -297,6 +934,58 @@ typedef PyClassWrapper<Context> PyContext;
 typedef PyClassWrapper<std::tr1::shared_ptr<Channel> > PyChannel;
 typedef PyClassWrapper<std::tr1::shared_ptr<OpBase> > PyOp;
 typedef PyClassWrapper<std::tr1::shared_ptr<MonitorOp> > PyMonitorOp;
+typedef PyClassWrapper<Selector::shared_pointer> PySelector;
+typedef PyClassWrapper<std::tr1::shared_ptr<GetterOp> > PyGetter;
+typedef PyClassWrapper<std::tr1::shared_ptr<PutterOp> > PyPutter;
+typedef PyClassWrapper<Dispatcher::shared_pointer> PyDispatcher;
+
+// shared by all operation timeouts.  Started when first needed, and never free'd.  guarded by GIL
+epicsTimerQueueActive *timerQueue;
+
+// Timer of an Op with a timeout.  Owned by the Op.
+// Only delete w/o GIL, as epicsTimer::destroy() waits for an expire() in progress,
+// which may need the GIL.
+struct Deadline : public epicsTimerNotify {
+    Channel::Op::weak_pointer op;
+    epicsTimer& timer;
+
+    struct Expire : public Dispatcher::Work {
+        Channel::Op::shared_pointer op;
+        Expire(const Channel::Op::shared_pointer& op) :op(op) {}
+        virtual ~Expire() {}
+        virtual void run() { op->expire(); }
+    };
+
+    Deadline(const Channel::Op::shared_pointer& op) :op(op), timer(timerQueue->createTimer()) {}
+    virtual ~Deadline() { timer.destroy(); }
+
+    // from the timer queue thread
+    virtual expireStatus expire(const epicsTime& currentTime) {
+        Channel::Op::shared_pointer O(op.lock());
+        if(O)
+            O->defer(Dispatcher::Work::shared_pointer(new Expire(O)));
+        return noRestart;
+    }
+};
+
+void Channel::Op::setDeadline(const Op::shared_pointer& self, double timeout)
+{
+    clearDeadline();
+    if(!timerQueue)
+        timerQueue = &epicsTimerQueueActive::allocate(true);
+    deadline = new Deadline(self);
+    deadline->timer.start(*deadline, timeout);
+}
+
+void Channel::Op::clearDeadline()
+{
+    Deadline *D = deadline;
+    if(!D)
+        return;
+    deadline = 0;
+    PyUnlock U;
+    delete D;
+}
 
 struct GetOp : public OpBase {
     POINTER_DEFINITIONS(GetOp);
@@ -372,6 +1061,10 @@ struct PutOp : public OpBase {
     virtual void restart(const Channel::Op::shared_pointer &self);
     virtual void lostConn(const Channel::Op::shared_pointer& self);
     virtual bool cancel();
+
+    // build the value and send.  call with GIL
+    void connected(pva::ChannelPut::shared_pointer const & channelPut,
+                   pvd::Structure::const_shared_pointer const & structure);
 };
 
 struct RPCOp : public OpBase {
@@ -409,94 +1102,319 @@ struct RPCOp : public OpBase {
     virtual bool cancel();
 };
 
-#define TRY PyContext::reference_type SELF = PyContext::unwrap(self); try
+// Fetch, and cache, the type of a Channel
+struct TypeOp : public OpBase {
+    POINTER_DEFINITIONS(TypeOp);
 
+    struct Req : public pva::GetFieldRequester {
+        POINTER_DEFINITIONS(Req);
 
-int Context::py_init(PyObject *self, PyObject *args, PyObject *kws)
-{
-    TRY {
-        static const char* names[] = {"provider", "conf", "useenv", NULL};
-        const char *pname;
-        PyObject *cdict = Py_None, *useenv = Py_True;
-        if(!PyArg_ParseTupleAndKeywords(args, kws, "s|OO", (char**)names, &pname, &cdict, &useenv))
-            return -1;
+        TypeOp::weak_pointer owner;
+        Req(const TypeOp::shared_pointer& o) : owner(o) {}
+        virtual ~Req() {}
 
-        pva::ConfigurationBuilder B;
+        virtual std::string getRequesterName() { return "p4p.TypeOp"; }
 
-        if(PyObject_IsTrue(useenv))
-            B.push_env();
+        virtual void getDone(
+            const pvd::Status& status,
+            pvd::FieldConstPtr const & field);
+    };
 
-        if(cdict==Py_None) {
-            // nothing
-        } else if(PyDict_Check(cdict)) {
-            Py_ssize_t I = 0;
-            PyObject *key, *value;
+    // Channel::connGen when getField() was sent
+    unsigned gen;
 
-            while(PyDict_Next(cdict, &I, &key, &value)) {
-                PyString K(key), V(value);
+    TypeOp(const Channel::shared_pointer& ch) :OpBase(ch), gen(0) {}
+    virtual ~TypeOp() {}
 
-                B.add(K.str(), V.str());
-            }
+    virtual void restart(const Channel::Op::shared_pointer &self);
+    virtual void lostConn(const Channel::Op::shared_pointer& self);
 
-            B.push_map();
-        } else {
-            PyErr_Format(PyExc_ValueError, "conf=%s not valid", Py_TYPE(cdict)->tp_name);
-            return -1;
-        }
+    // cache and complete.  call with GIL
+    void done(const pvd::Status& status, pvd::FieldConstPtr const & field);
+};
 
-        // we create our own provider.
-        // we are greedy and don't want to share (also we can destroy channels at will)
-#if 0
-        // No way to apply custom config :P
-        SELF.provider = pva::getChannelProviderRegistry()->createProvider(pname);
-#else
-        SELF.provider = pva::getChannelProviderRegistry()->createProvider(pname, B.build());
-#endif
+// Keeps one ChannelGet open for repeated get().
+// Re-created on reconnect.  A get() in progress when the connection is lost is re-issued.
+struct GetterOp : public Channel::Op {
+    POINTER_DEFINITIONS(GetterOp);
 
-        TRACE("Context init");
+    struct Req : public pva::ChannelGetRequester, public std::tr1::enable_shared_from_this<Req> {
+        POINTER_DEFINITIONS(Req);
 
-        if(!SELF.provider)
-            throw std::logic_error("createProvider returns NULL");
+        GetterOp::weak_pointer owner;
+        Req(const GetterOp::shared_pointer& o) : owner(o) {}
+        virtual ~Req() {}
 
-        SELF.name = strdup(pname);
+        virtual std::string getRequesterName() { return "p4p.GetterOp"; }
 
-        return 0;
-    } CATCH()
-    return -1;
-}
+        virtual void channelGetConnect(
+            const pvd::Status& status,
+            pva::ChannelGet::shared_pointer const & channelGet,
+            pvd::Structure::const_shared_pointer const & structure);
 
-PyObject *Context::py_channel(PyObject *self, PyObject *args, PyObject *kws)
-{
-    TRY {
-        static const char* names[] = {"channel", NULL};
-        char *cname;
-        if(!PyArg_ParseTupleAndKeywords(args, kws, "s", (char**)names, &cname))
-            return NULL;
+        virtual void getDone(
+            const pvd::Status& status,
+            pva::ChannelGet::shared_pointer const & channelGet,
+            pvd::PVStructure::shared_pointer const & pvStructure,
+            pvd::BitSet::shared_pointer const & bitSet);
 
-        if(!SELF.provider)
-            return PyErr_Format(PyExc_RuntimeError, "Context has been closed");
+        // handle the above with GIL
+        void connected(const pvd::Status& status, pva::ChannelGet::shared_pointer const & channelGet);
+        void done(const pvd::Status& status,
+                  pvd::PVStructure::shared_pointer const & pvStructure,
+                  pvd::BitSet::shared_pointer const & bitSet);
+    };
 
-        PyRef klass(PyObject_GetAttrString(self, "Channel"));
-        if(!PyType_Check(klass.get()) || !PyType_IsSubtype((PyTypeObject*)klass.get(), &PyChannel::type))
-            return PyErr_Format(PyExc_RuntimeError, "self.Channel not valid");
-        PyTypeObject *chanklass = (PyTypeObject*)klass.get();
+    // a callback from the ChannelGet, handled with GIL.
+    // The ChannelGet does not re-use pvStructure until the next get(),
+    // which is not sent until this is handled.
+    struct Event : public Dispatcher::Work {
+        Req::shared_pointer req;
+        bool connect;
+        pvd::Status status;
+        pva::ChannelGet::shared_pointer channelGet;
+        pvd::PVStructure::shared_pointer pvStructure;
+        pvd::BitSet::shared_pointer bitSet;
+        Event(const Req::shared_pointer& req, const pvd::Status& status, pva::ChannelGet::shared_pointer const & channelGet)
+            :req(req), connect(true), status(status), channelGet(channelGet) {}
+        Event(const Req::shared_pointer& req, const pvd::Status& status,
+              pvd::PVStructure::shared_pointer const & pvStructure, pvd::BitSet::shared_pointer const & bitSet)
+            :req(req), connect(false), status(status), pvStructure(pvStructure), bitSet(bitSet) {}
+        virtual ~Event() {}
+        virtual void run() {
+            if(connect)
+                req->connected(status, channelGet);
+            else
+                req->done(status, pvStructure, bitSet);
+        }
+    };
 
-        Channel::shared_pointer pychan(new Channel);
-        Channel::Req::shared_pointer pyreq(new Channel::Req(pychan));
+    // all guarded by GIL
+    pvd::PVStructure::shared_pointer req;
+    pva::ChannelGet::shared_pointer op;
+    // requester of 'op'.  callbacks from previous ChannelGets are ignored
+    Req::shared_pointer current;
+    // callback of the get() in progress
+    PyRef cb;
+    // channelGetConnect() has succeeded for 'op'
+    bool ready;
+    // channelGetConnect() has failed for 'op'.  The next get() restart()s
+    bool failed;
+    // get() has been sent, and getDone() not yet called
+    bool inprog;
+    // copy into the storage of the previous Value when it is no longer referenced
+    bool recycle;
+    pvd::PVStructure::shared_pointer last;
+
+    GetterOp(const Channel::shared_pointer& ch) :Channel::Op(ch), ready(false), failed(false), inprog(false), recycle(false) {}
+    virtual ~GetterOp() {}
 
-        pva::Channel::shared_pointer chan;
+    virtual void restart(const Channel::Op::shared_pointer &self);
+    virtual void lostConn(const Channel::Op::shared_pointer& self);
+    virtual bool cancel();
 
-        std::string chanName(cname);
+    // send get() if requested and connected.  call with GIL
+    void issue();
+    // copy of a get() result, or the result itself
+    pvd::PVStructure::shared_pointer result(const pvd::PVStructure::shared_pointer& V);
 
-        {
-            PyUnlock U;
-            chan = SELF.provider->createChannel(chanName, pyreq);
+    static PyObject *py_get(PyObject *self, PyObject *args, PyObject *kws);
+    static PyObject *py_close(PyObject *self);
+
+    static int py_traverse(PyObject *self, visitproc visit, void *arg);
+    static int py_clear(PyObject *self);
+};
+
+// Keeps one ChannelPut open for repeated put().
+// Re-created on reconnect.  Only the fields marked as changed are sent.
+struct PutterOp : public Channel::Op {
+    POINTER_DEFINITIONS(PutterOp);
+
+    struct Req : public pva::ChannelPutRequester, public std::tr1::enable_shared_from_this<Req> {
+        POINTER_DEFINITIONS(Req);
+
+        PutterOp::weak_pointer owner;
+        Req(const PutterOp::shared_pointer& o) : owner(o) {}
+        virtual ~Req() {}
+
+        virtual std::string getRequesterName() { return "p4p.PutterOp"; }
+
+        virtual void channelPutConnect(
+            const pvd::Status& status,
+            pva::ChannelPut::shared_pointer const & channelPut,
+            pvd::Structure::const_shared_pointer const & structure);
+
+        virtual void putDone(
+            const pvd::Status& status,
+            pva::ChannelPut::shared_pointer const & channelPut);
+
+        virtual void getDone(
+            const pvd::Status& status,
+            pva::ChannelPut::shared_pointer const & channelPut,
+            pvd::PVStructure::shared_pointer const & pvStructure,
+            pvd::BitSet::shared_pointer const & bitSet)
+        { /* no used */ }
+
+        // handle the above with GIL
+        void connected(const pvd::Status& status,
+                       pva::ChannelPut::shared_pointer const & channelPut,
+                       pvd::Structure::const_shared_pointer const & structure);
+        void done(const pvd::Status& status);
+    };
+
+    // a callback from the ChannelPut, handled with GIL
+    struct Event : public Dispatcher::Work {
+        Req::shared_pointer req;
+        bool connect;
+        pvd::Status status;
+        pva::ChannelPut::shared_pointer channelPut;
+        pvd::Structure::const_shared_pointer structure;
+        Event(const Req::shared_pointer& req, const pvd::Status& status,
+              pva::ChannelPut::shared_pointer const & channelPut, pvd::Structure::const_shared_pointer const & structure)
+            :req(req), connect(true), status(status), channelPut(channelPut), structure(structure) {}
+        Event(const Req::shared_pointer& req, const pvd::Status& status)
+            :req(req), connect(false), status(status) {}
+        virtual ~Event() {}
+        virtual void run() {
+            if(connect)
+                req->connected(status, channelPut, structure);
+            else
+                req->done(status);
+        }
+    };
+
+    // all guarded by GIL
+    pvd::PVStructure::shared_pointer req;
+    pva::ChannelPut::shared_pointer op;
+    // requester of 'op'.  callbacks from previous ChannelPuts are ignored
+    Req::shared_pointer current;
+    // server type, once connected
+    pvd::Structure::const_shared_pointer type;
+    // callback of the put() in progress
+    PyRef cb;
+    // value and mask of the put() in progress
+    pvd::PVStructure::shared_pointer value;
+    pvd::BitSet::shared_pointer mask;
+    // channelPutConnect() has succeeded for 'op'
+    bool ready;
+    // put() has been sent, and putDone() not yet called
+    bool inprog;
+
+    PutterOp(const Channel::shared_pointer& ch) :Channel::Op(ch), ready(false), inprog(false) {}
+    virtual ~PutterOp() {}
+
+    virtual void restart(const Channel::Op::shared_pointer &self);
+    virtual void lostConn(const Channel::Op::shared_pointer& self);
+    virtual bool cancel();
+
+    // send put() if requested and connected.  call with GIL
+    void issue();
+    // complete the put() in progress.  call with GIL
+    void complete(PyObject *obj);
+
+    static PyObject *py_put(PyObject *self, PyObject *args, PyObject *kws);
+    static PyObject *py_type(PyObject *self);
+    static PyObject *py_value(PyObject *self);
+    static PyObject *py_close(PyObject *self);
+
+    static int py_traverse(PyObject *self, visitproc visit, void *arg);
+    static int py_clear(PyObject *self);
+};
+
+#define TRY PyContext::reference_type SELF = PyContext::unwrap(self); try
+
+
+int Context::py_init(PyObject *self, PyObject *args, PyObject *kws)
+{
+    TRY {
+        static const char* names[] = {"provider", "conf", "useenv", "idleTimeout", "maxIdle", "dispatcher", NULL};
+        const char *pname;
+        PyObject *cdict = Py_None, *useenv = Py_True, *pydispatch = Py_None;
+        double idleTimeout = 30.0;
+        Py_ssize_t maxIdle = 1024;
+        if(!PyArg_ParseTupleAndKeywords(args, kws, "s|OOdnO", (char**)names, &pname, &cdict, &useenv,
+                                        &idleTimeout, &maxIdle, &pydispatch))
+            return -1;
+
+        if(maxIdle<0) {
+            PyErr_SetString(PyExc_ValueError, "maxIdle must not be negative");
+            return -1;
+        }
+
+        if(pydispatch!=Py_None && !PyObject_TypeCheck(pydispatch, &PyDispatcher::type)) {
+            PyErr_Format(PyExc_TypeError, "dispatcher must be a Dispatcher or None, not %s", Py_TYPE(pydispatch)->tp_name);
+            return -1;
+        }
+
+        pva::ConfigurationBuilder B;
+
+        if(PyObject_IsTrue(useenv))
+            B.push_env();
+
+        if(cdict==Py_None) {
+            // nothing
+        } else if(PyDict_Check(cdict)) {
+            Py_ssize_t I = 0;
+            PyObject *key, *value;
+
+            while(PyDict_Next(cdict, &I, &key, &value)) {
+                PyString K(key), V(value);
+
+                B.add(K.str(), V.str());
+            }
+
+            B.push_map();
+        } else {
+            PyErr_Format(PyExc_ValueError, "conf=%s not valid", Py_TYPE(cdict)->tp_name);
+            return -1;
         }
 
-        if(!chan)
-            return PyErr_Format(PyExc_RuntimeError, "Failed to create channel '%s'", cname);
+        // we create our own provider.
+        // we are greedy and don't want to share (also we can destroy channels at will)
+#if 0
+        // No way to apply custom config :P
+        SELF.provider = pva::getChannelProviderRegistry()->createProvider(pname);
+#else
+        SELF.provider = pva::getChannelProviderRegistry()->createProvider(pname, B.build());
+#endif
+
+        TRACE("Context init");
+
+        if(!SELF.provider)
+            throw std::logic_error("createProvider returns NULL");
+
+        SELF.name = strdup(pname);
+
+        SELF.pool.reset(new ChannelPool);
+        SELF.pool->maxAge = idleTimeout;
+        SELF.pool->maxIdle = maxIdle;
+
+        if(pydispatch!=Py_None)
+            SELF.dispatch = PyDispatcher::unwrap(pydispatch);
+
+        return 0;
+    } CATCH()
+    return -1;
+}
+
+PyObject *Context::py_channel(PyObject *self, PyObject *args, PyObject *kws)
+{
+    TRY {
+        static const char* names[] = {"channel", "priority", NULL};
+        char *cname;
+        short prio = pva::ChannelProvider::PRIORITY_DEFAULT;
+        if(!PyArg_ParseTupleAndKeywords(args, kws, "s|h", (char**)names, &cname, &prio))
+            return NULL;
+
+        if(!SELF.provider)
+            return PyErr_Format(PyExc_RuntimeError, "Context has been closed");
 
-        pychan->channel = chan;
+        PyRef klass(PyObject_GetAttrString(self, "Channel"));
+        if(!PyType_Check(klass.get()) || !PyType_IsSubtype((PyTypeObject*)klass.get(), &PyChannel::type))
+            return PyErr_Format(PyExc_RuntimeError, "self.Channel not valid");
+        PyTypeObject *chanklass = (PyTypeObject*)klass.get();
+
+        Channel::shared_pointer pychan(SELF.getChannel(cname, prio));
 
         PyRef ret(chanklass->tp_new(chanklass, args, kws));
 
@@ -505,15 +1423,101 @@ PyObject *Context::py_channel(PyObject *self, PyObject *args, PyObject *kws)
         if(chanklass->tp_init && chanklass->tp_init(ret.get(), args, kws))
             throw std::runtime_error("Error Channel.__init__");
 
-        TRACE("Channel "<<cname<<" "<<chan);
+        TRACE("Channel "<<cname);
         return ret.release();
     } CATCH()
     return NULL;
 }
 
+Channel::shared_pointer Context::getChannel(const std::string& name, short prio)
+{
+    std::vector<std::string> names(1, name);
+    std::vector<Channel::shared_pointer> chans;
+    getChannels(names, prio, chans);
+    return chans[0];
+}
+
+void Context::getChannels(const std::vector<std::string>& names, short prio, std::vector<Channel::shared_pointer>& chans)
+{
+    if(!provider)
+        throw std::runtime_error("Context has been closed");
+
+    {
+        // now idle, from this time
+        epicsTime now(epicsTime::getCurrent());
+        while(!pins.empty() && pins.begin()->first <= now)
+            pins.erase(pins.begin());
+    }
+    {
+        std::vector<Channel::shared_pointer> trash;
+        pool->expire(trash);
+        destroy_channels(trash);
+    }
+
+    chans.resize(names.size());
+
+    // Channels to be created, and the names which will use each
+    std::map<std::string, size_t> pending;
+    std::vector<std::string> newnames;
+    std::vector<Channel::shared_pointer> newchans;
+    std::vector<Channel::Req::shared_pointer> newreqs;
+    std::vector<size_t> which(names.size(), size_t(-1));
+
+    for(size_t i=0; i<names.size(); i++) {
+        chans[i] = ChannelPool::acquire(pool, ChannelPool::key_type(names[i], prio));
+        if(chans[i])
+            continue;
+
+        std::map<std::string, size_t>::const_iterator it(pending.find(names[i]));
+        if(it!=pending.end()) {
+            which[i] = it->second;
+            continue;
+        }
+        Channel::shared_pointer newchan(new Channel);
+        newchan->dispatch = dispatch;
+
+        which[i] = pending[names[i]] = newchans.size();
+        newnames.push_back(names[i]);
+        newchans.push_back(newchan);
+        newreqs.push_back(Channel::Req::shared_pointer(new Channel::Req(newchan)));
+    }
+
+    std::vector<pva::Channel::shared_pointer> created(newchans.size());
+    {
+        PyUnlock U;
+        for(size_t n=0; n<newchans.size(); n++)
+            created[n] = provider->createChannel(newnames[n], newreqs[n], prio);
+    }
+
+    std::string failed;
+    for(size_t n=0; n<newchans.size(); n++) {
+        if(!created[n]) {
+            failed = newnames[n];
+            newchans[n].reset();
+            continue;
+        }
+        newchans[n]->channel = created[n];
+        newchans[n] = ChannelPool::add(pool, ChannelPool::key_type(newnames[n], prio), newchans[n]);
+    }
+
+    if(!failed.empty())
+        throw std::runtime_error(SB()<<"Failed to create channel '"<<failed<<"'");
+
+    for(size_t i=0; i<names.size(); i++) {
+        if(which[i]!=size_t(-1))
+            chans[i] = newchans[which[i]];
+    }
+}
+
 void Context::close()
 {
     TRACE("Context close");
+    pins.clear();
+    if(pool) {
+        std::vector<Channel::shared_pointer> trash;
+        pool->clear(trash);
+        destroy_channels(trash);
+    }
     if(provider) {
         PyUnlock U;
         provider.reset();
@@ -529,6 +1533,22 @@ PyObject *Context::py_close(PyObject *self)
     return NULL;
 }
 
+PyObject *Context::py_poolStats(PyObject *self)
+{
+    TRY {
+        size_t nchan = 0, nidle = 0;
+        if(SELF.pool) {
+            Guard G(SELF.pool->lock);
+            nchan = SELF.pool->entries.size();
+            nidle = SELF.pool->idle.size();
+        }
+        return Py_BuildValue("{snsn}",
+                             "channels", Py_ssize_t(nchan),
+                             "idle", Py_ssize_t(nidle));
+    } CATCH()
+    return NULL;
+}
+
 PyObject*  Context::py_providers(PyObject *junk)
 {
     try {
@@ -619,105 +1639,485 @@ pvd::PVStructure::shared_pointer buildRequest(PyObject *req)
     return opts;
 }
 
-#undef TRY
-#define TRY PyChannel::reference_type SELF = PyChannel::unwrap(self); try
+typedef std::map<std::string, std::string> options_t;
 
-int Channel::py_init(PyObject *self, PyObject *args, PyObject *kws)
+// Copy of a pvRequest with 'opts' added to, or replacing entries of, record._options
+pvd::PVStructure::shared_pointer requestOptions(const pvd::PVStructure::shared_pointer& req,
+                                                const options_t& opts)
 {
-    TRY {
-        // ignores arguments
-        if(!SELF->channel) {
-            PyErr_Format(PyExc_ValueError, "Can't construct Channel explicitly");
-            return 1;
+    if(opts.empty())
+        return req;
+
+    options_t all;
+    pvd::PVStructurePtr prev(req->getSubField<pvd::PVStructure>("record._options"));
+    if(prev) {
+        const pvd::StringArray& names(prev->getStructure()->getFieldNames());
+        const pvd::PVFieldPtrArray& flds(prev->getPVFields());
+        for(size_t i=0; i<flds.size(); i++) {
+            if(flds[i]->getField()->getType()==pvd::scalar)
+                all[names[i]] = static_cast<pvd::PVScalar*>(flds[i].get())->getAs<std::string>();
         }
+    }
+    for(options_t::const_iterator it(opts.begin()), end(opts.end()); it!=end; ++it)
+        all[it->first] = it->second;
 
-        return 0;
-    }CATCH();
-    return 1;
+    const pvd::StringArray& names(req->getStructure()->getFieldNames());
+    const pvd::FieldConstPtrArray& types(req->getStructure()->getFields());
+
+    pvd::FieldBuilderPtr builder(pvd::getFieldCreate()->createFieldBuilder());
+    for(size_t i=0; i<names.size(); i++) {
+        if(names[i]!="record")
+            builder = builder->add(names[i], types[i]);
+    }
+    builder = builder->addNestedStructure("record")
+                     ->addNestedStructure("_options");
+    for(options_t::const_iterator it(all.begin()), end(all.end()); it!=end; ++it)
+        builder = builder->add(it->first, pvd::pvString);
+    builder = builder->endNested()
+                     ->endNested();
+
+    pvd::PVStructure::shared_pointer ret(pvd::getPVDataCreate()->createPVStructure(builder->createStructure()));
+
+    const pvd::PVFieldPtrArray& flds(req->getPVFields());
+    for(size_t i=0; i<flds.size(); i++) {
+        if(names[i]=="record")
+            continue;
+        pvd::PVField *dest = ret->getSubFieldT(names[i]).get();
+        switch(types[i]->getType()) {
+        case pvd::structure:
+            static_cast<pvd::PVStructure*>(dest)->copy(*static_cast<pvd::PVStructure*>(flds[i].get()));
+            break;
+        case pvd::scalar:
+            static_cast<pvd::PVScalar*>(dest)->putFrom(static_cast<pvd::PVScalar*>(flds[i].get())->getAs<std::string>());
+            break;
+        default:
+            break; // not meaningful in a pvRequest
+        }
+    }
+
+    for(options_t::const_iterator it(all.begin()), end(all.end()); it!=end; ++it)
+        ret->getSubFieldT<pvd::PVString>("record._options."+it->first)->put(it->second);
+
+    return ret;
 }
 
-PyObject* Channel::py_get(PyObject *self, PyObject *args, PyObject *kws)
+// The i'th of a list or tuple, or the same object for all
+struct BulkArg {
+    PyRef seq;
+    PyObject *one;
+    BulkArg(PyObject *arg, size_t count, const char *name, bool required)
+        :one(arg)
+    {
+        if(required || PyList_Check(arg) || PyTuple_Check(arg)) {
+            seq.reset(PySequence_Fast(arg, "Expected a sequence"));
+            if(size_t(PySequence_Fast_GET_SIZE(seq.get()))!=count) {
+                PyErr_Format(PyExc_ValueError, "Length of %s must match names", name);
+                throw std::runtime_error("length mis-match");
+            }
+        }
+    }
+    PyObject *operator[](size_t i) const {
+        return seq.get() ? PySequence_Fast_GET_ITEM(seq.get(), i) : one;
+    }
+};
+
+// cancel() operations when leaving scope.  with GIL
+struct BulkOps {
+    std::vector<OpBase::shared_pointer> ops;
+    ~BulkOps() {
+        for(size_t i=0; i<ops.size(); i++) {
+            try {
+                ops[i]->cancel();
+            } catch(std::exception& e) {
+                std::cerr<<"Error in cancel() "<<e.what()<<"\n";
+            }
+        }
+    }
+    void start(const OpBase::shared_pointer& op)
+    {
+        ops.push_back(op);
+        op->channel->start(op);
+    }
+};
+
+// Wait, with the GIL released, until all operations complete, or timeout.
+// false (with python exception) if interrupted
+bool bulk_wait(const BulkWait::shared_pointer& W, double timeout)
 {
-    TRY {
-        static const char *names[] = {"callback", "request", NULL};
-        PyObject *cb, *req = Py_None;
-        if(!PyArg_ParseTupleAndKeywords(args, kws, "O|O", (char**)names, &cb, &req))
-            return NULL;
+    epicsTime deadline(epicsTime::getCurrent() + (timeout<0.0 ? 0.0 : timeout));
 
-        if(!PyCallable_Check(cb))
-            return PyErr_Format(PyExc_ValueError, "callable required, not %s", Py_TYPE(cb)->tp_name);
+    while(true) {
+        bool fin;
+        {
+            PyUnlock U;
 
-        if(!SELF->channel)
-            return PyErr_Format(PyExc_RuntimeError, "Channel closed");
+            // wake periodically to check for signals (eg. KeyboardInterrupt)
+            double left = 1.0;
+            if(timeout>=0.0)
+                left = std::min(left, deadline - epicsTime::getCurrent());
 
-        TRACE("Channel get "<<SELF->channel->getChannelName());
+            {
+                Guard G(W->lock);
+                fin = W->remaining==0;
+            }
+            if(!fin && left>0.0) {
+                W->done.wait(left);
+                Guard G(W->lock);
+                fin = W->remaining==0;
+            }
+        }
+        if(fin || (timeout>=0.0 && epicsTime::getCurrent() >= deadline))
+            return true;
+        if(PyErr_CheckSignals())
+            return false;
+    }
+}
 
-        GetOp::shared_pointer reqop(new GetOp(SELF));
-        reqop->cb.reset(cb, borrow());
-        reqop->req = buildRequest(req);
+// Wait, as bulk_wait(), then return a list of results.  Value, None, or an Exception.
+PyObject *bulk_collect(const BulkWait::shared_pointer& W, double timeout)
+{
+    if(!bulk_wait(W, timeout))
+        return NULL;
 
-        //TODO: PVA provider lets us start get() when not connected
-        //      CA provider fails.
-        //      Race with connection test?
+    size_t N = W->complete.size();
+    PyRef ret(PyList_New(N));
+
+    for(size_t i=0; i<N; i++) {
+        PyRef R;
+        bool complete;
+        pvd::PVStructure::shared_pointer val;
+        std::string err;
+        {
+            Guard G(W->lock);
+            complete = W->complete[i];
+            val = W->values[i];
+            err = W->errors[i];
+            R.swap(W->pyresults[i]);
+        }
 
-        if(SELF->channel->isConnected()) {
-            TRACE("Issue get");
-            reqop->restart(reqop);
+        if(R.get()) {
+            // from put value builder
+        } else if(!complete) {
+            R.reset(PyObject_CallFunction(P4PTimeout, "s", "Timeout"));
+        } else if(!err.empty()) {
+            R.reset(PyObject_CallFunction(PyExc_RuntimeError, "s", err.c_str()));
+        } else if(val) {
+            R.reset(P4PValue_wrap(P4PValue_type, val));
         } else {
-            TRACE("Wait for connect refs="<<reqop.use_count());
-            SELF->ops.insert(reqop);
+            R.reset(Py_None, borrow());
         }
 
-        try {
-            PyRef ret(PyOp::type.tp_new(&PyOp::type, args, kws));
+        PyList_SET_ITEM(ret.get(), i, R.release());
+    }
 
-            PyOp::unwrap(ret.get()) = reqop;
+    return ret.release();
+}
 
-            return ret.release();
-        }catch(...) {
-            reqop->op->destroy();
-            SELF->ops.erase(reqop);
-            throw;
+// the Channel of each name of a bulk operation, found or created together
+void bulk_channels(Context& ctxt, PyObject *names, std::vector<Channel::shared_pointer>& chans)
+{
+    size_t count = PySequence_Fast_GET_SIZE(names);
+    std::vector<std::string> cnames(count);
+    for(size_t i=0; i<count; i++)
+        cnames[i] = PyString(PySequence_Fast_GET_ITEM(names, i)).str();
+
+    ctxt.getChannels(cnames, pva::ChannelProvider::PRIORITY_DEFAULT, chans);
+}
+
+PyObject *Context::py_get_many(PyObject *self, PyObject *args, PyObject *kws)
+{
+    TRY {
+        static const char* names[] = {"names", "requests", "timeout", NULL};
+        PyObject *pvnames, *reqs = Py_None;
+        double timeout = 5.0;
+        if(!PyArg_ParseTupleAndKeywords(args, kws, "O|Od", (char**)names, &pvnames, &reqs, &timeout))
+            return NULL;
+
+        PyRef N(PySequence_Fast(pvnames, "names must be a sequence"));
+        size_t count = PySequence_Fast_GET_SIZE(N.get());
+        BulkArg R(reqs, count, "requests", false);
+
+        std::vector<Channel::shared_pointer> chans;
+        bulk_channels(SELF, N.get(), chans);
+
+        BulkWait::shared_pointer W(new BulkWait(count));
+        BulkOps ops;
+
+        for(size_t i=0; i<count; i++) {
+            GetOp::shared_pointer op(new GetOp(chans[i]));
+            op->req = buildRequest(R[i]);
+            op->bulk = W;
+            op->bulkIndex = i;
+
+            ops.start(op);
         }
+
+        return bulk_collect(W, timeout);
     }CATCH()
     return NULL;
 }
 
-PyObject* Channel::py_put(PyObject *self, PyObject *args, PyObject *kws)
+PyObject *Context::py_put_many(PyObject *self, PyObject *args, PyObject *kws)
 {
     TRY {
-        static const char *names[] = {"callback", "value", "request", NULL};
-        PyObject *cb, *val, *req = Py_None;
-        if(!PyArg_ParseTupleAndKeywords(args, kws, "OO|O", (char**)names, &cb, &val, &req))
+        static const char* names[] = {"names", "values", "requests", "timeout", NULL};
+        PyObject *pvnames, *vals, *reqs = Py_None;
+        double timeout = 5.0;
+        if(!PyArg_ParseTupleAndKeywords(args, kws, "OO|Od", (char**)names, &pvnames, &vals, &reqs, &timeout))
             return NULL;
 
-        if(!PyCallable_Check(cb))
-            return PyErr_Format(PyExc_ValueError, "callable required, not %s", Py_TYPE(cb)->tp_name);
+        PyRef N(PySequence_Fast(pvnames, "names must be a sequence"));
+        size_t count = PySequence_Fast_GET_SIZE(N.get());
+        BulkArg V(vals, count, "values", true);
+        BulkArg R(reqs, count, "requests", false);
 
-        if(PyObject_IsInstance(val, (PyObject*)P4PValue_type)) { /* ok */ }
-        else if(PyCallable_Check(val)) { /* ok */ }
-        else {
-            return PyErr_Format(PyExc_ValueError, "put value must be Value or callable which returns Value");
+        for(size_t i=0; i<count; i++) {
+            if(!PyObject_IsInstance(V[i], (PyObject*)P4PValue_type) && !PyCallable_Check(V[i]))
+                return PyErr_Format(PyExc_ValueError, "put value must be Value or callable which returns Value");
         }
 
-        if(!SELF->channel)
-            return PyErr_Format(PyExc_RuntimeError, "Channel closed");
+        std::vector<Channel::shared_pointer> chans;
+        bulk_channels(SELF, N.get(), chans);
 
-        TRACE("Channel put "<<SELF->channel->getChannelName());
+        BulkWait::shared_pointer W(new BulkWait(count));
+        BulkOps ops;
 
-        PutOp::shared_pointer reqop(new PutOp(SELF));
+        for(size_t i=0; i<count; i++) {
+            PutOp::shared_pointer op(new PutOp(chans[i]));
+            op->pyvalue.reset(V[i], borrow());
+            op->req = buildRequest(R[i]);
+            op->bulk = W;
+            op->bulkIndex = i;
+
+            ops.start(op);
+        }
+
+        return bulk_collect(W, timeout);
+    }CATCH()
+    return NULL;
+}
+
+PyObject *Context::py_rpc_many(PyObject *self, PyObject *args, PyObject *kws)
+{
+    TRY {
+        static const char* names[] = {"names", "values", "requests", "timeout", NULL};
+        PyObject *pvnames, *vals, *reqs = Py_None;
+        double timeout = 5.0;
+        if(!PyArg_ParseTupleAndKeywords(args, kws, "OO|Od", (char**)names, &pvnames, &vals, &reqs, &timeout))
+            return NULL;
+
+        PyRef N(PySequence_Fast(pvnames, "names must be a sequence"));
+        size_t count = PySequence_Fast_GET_SIZE(N.get());
+        BulkArg V(vals, count, "values", true);
+        BulkArg R(reqs, count, "requests", false);
+
+        for(size_t i=0; i<count; i++) {
+            if(!PyObject_IsInstance(V[i], (PyObject*)P4PValue_type))
+                return PyErr_Format(PyExc_ValueError, "rpc value must be Value");
+        }
+
+        std::vector<Channel::shared_pointer> chans;
+        bulk_channels(SELF, N.get(), chans);
+
+        BulkWait::shared_pointer W(new BulkWait(count));
+        BulkOps ops;
+
+        for(size_t i=0; i<count; i++) {
+            RPCOp::shared_pointer op(new RPCOp(chans[i]));
+            op->pvvalue = P4PValue_unwrap(V[i]);
+            op->req = buildRequest(R[i]);
+            op->bulk = W;
+            op->bulkIndex = i;
+
+            ops.start(op);
+        }
+
+        return bulk_collect(W, timeout);
+    }CATCH()
+    return NULL;
+}
+
+PyObject *Context::py_connect_many(PyObject *self, PyObject *args, PyObject *kws)
+{
+    TRY {
+        static const char* names[] = {"names", "timeout", "keep", NULL};
+        PyObject *pvnames, *pykeep = Py_None;
+        double timeout = 5.0;
+        if(!PyArg_ParseTupleAndKeywords(args, kws, "O|dO", (char**)names, &pvnames, &timeout, &pykeep))
+            return NULL;
+
+        double keep = -1.0;
+        if(pykeep!=Py_None) {
+            keep = PyFloat_AsDouble(pykeep);
+            if(PyErr_Occurred())
+                return NULL;
+            if(keep<0.0)
+                return PyErr_Format(PyExc_ValueError, "keep must not be negative");
+        }
+
+        PyRef N(PySequence_Fast(pvnames, "names must be a sequence"));
+        size_t count = PySequence_Fast_GET_SIZE(N.get());
+
+        std::vector<Channel::shared_pointer> chans;
+        bulk_channels(SELF, N.get(), chans);
+
+        // each Channel once, as a name may be repeated
+        std::map<Channel*, size_t> unique;
+        std::vector<Channel::shared_pointer> uchans;
+        for(size_t i=0; i<count; i++) {
+            if(unique.find(chans[i].get())==unique.end()) {
+                unique[chans[i].get()] = uchans.size();
+                uchans.push_back(chans[i]);
+            }
+        }
+
+        if(keep>=0.0) {
+            // not idle, so neither maxIdle nor idleTimeout apply, until then
+            epicsTime until(epicsTime::getCurrent() + keep);
+            for(size_t n=0; n<uchans.size(); n++)
+                SELF.pins.insert(std::make_pair(until, uchans[n]));
+        }
+
+        BulkWait::shared_pointer W(new BulkWait(uchans.size()));
+
+        for(size_t n=0; n<uchans.size(); n++) {
+            Channel& ch = *uchans[n];
+            bool conn;
+            {
+                Guard G(ch.lock);
+                conn = ch.connected;
+                if(!conn)
+                    ch.waiters.push_back(std::make_pair(W, n));
+            }
+            if(conn)
+                W->finish(n, pvd::Status(), pvd::PVStructure::shared_pointer());
+        }
+
+        bool ok = bulk_wait(W, timeout);
+
+        std::vector<bool> connected(uchans.size());
+        for(size_t n=0; n<uchans.size(); n++) {
+            Channel& ch = *uchans[n];
+            Guard G(ch.lock);
+            connected[n] = ch.connected;
+            for(Channel::waiters_t::iterator it(ch.waiters.begin()); it!=ch.waiters.end();) {
+                if(it->first==W)
+                    it = ch.waiters.erase(it);
+                else
+                    ++it;
+            }
+        }
+
+        if(!ok)
+            return NULL;
+
+        PyRef conn(PySet_New(NULL)), unconn(PySet_New(NULL));
+
+        for(size_t i=0; i<count; i++) {
+            PyObject *S = connected[unique[chans[i].get()]] ? conn.get() : unconn.get();
+            if(PySet_Add(S, PySequence_Fast_GET_ITEM(N.get(), i)))
+                return NULL;
+        }
+
+        return PyTuple_Pack(2, conn.get(), unconn.get());
+    }CATCH()
+    return NULL;
+}
+
+#undef TRY
+#define TRY PyChannel::reference_type SELF = PyChannel::unwrap(self); try
+
+int Channel::py_init(PyObject *self, PyObject *args, PyObject *kws)
+{
+    TRY {
+        // ignores arguments
+        if(!SELF->channel) {
+            PyErr_Format(PyExc_ValueError, "Can't construct Channel explicitly");
+            return 1;
+        }
+
+        return 0;
+    }CATCH();
+    return 1;
+}
+
+PyObject* Channel::py_get(PyObject *self, PyObject *args, PyObject *kws)
+{
+    TRY {
+        static const char *names[] = {"callback", "request", "timeout", NULL};
+        PyObject *cb, *req = Py_None;
+        double timeout = 0.0;
+        if(!PyArg_ParseTupleAndKeywords(args, kws, "O|Od", (char**)names, &cb, &req, &timeout))
+            return NULL;
+
+        if(!PyCallable_Check(cb))
+            return PyErr_Format(PyExc_ValueError, "callable required, not %s", Py_TYPE(cb)->tp_name);
+
+        if(!SELF->channel)
+            return PyErr_Format(PyExc_RuntimeError, "Channel closed");
+
+        TRACE("Channel get "<<SELF->channel->getChannelName());
+
+        GetOp::shared_pointer reqop(new GetOp(SELF));
         reqop->cb.reset(cb, borrow());
-        reqop->pyvalue.reset(val, borrow());
         reqop->req = buildRequest(req);
 
-        if(SELF->channel->isConnected()) {
-            TRACE("Issue put");
-            reqop->restart(reqop);
-        } else {
-            TRACE("Wait for connect");
-            SELF->ops.insert(reqop);
+        //TODO: PVA provider lets us start get() when not connected
+        //      CA provider fails.
+        //      Race with connection test?
+
+        SELF->start(reqop);
+
+        if(timeout>0.0)
+            reqop->setDeadline(reqop, timeout);
+
+        try {
+            PyRef ret(PyOp::type.tp_new(&PyOp::type, args, kws));
+
+            PyOp::unwrap(ret.get()) = reqop;
+
+            return ret.release();
+        }catch(...) {
+            reqop->cancel();
+            throw;
+        }
+    }CATCH()
+    return NULL;
+}
+
+PyObject* Channel::py_put(PyObject *self, PyObject *args, PyObject *kws)
+{
+    TRY {
+        static const char *names[] = {"callback", "value", "request", "timeout", NULL};
+        PyObject *cb, *val, *req = Py_None;
+        double timeout = 0.0;
+        if(!PyArg_ParseTupleAndKeywords(args, kws, "OO|Od", (char**)names, &cb, &val, &req, &timeout))
+            return NULL;
+
+        if(!PyCallable_Check(cb))
+            return PyErr_Format(PyExc_ValueError, "callable required, not %s", Py_TYPE(cb)->tp_name);
+
+        if(PyObject_IsInstance(val, (PyObject*)P4PValue_type)) { /* ok */ }
+        else if(PyCallable_Check(val)) { /* ok */ }
+        else {
+            return PyErr_Format(PyExc_ValueError, "put value must be Value or callable which returns Value");
         }
 
+        if(!SELF->channel)
+            return PyErr_Format(PyExc_RuntimeError, "Channel closed");
+
+        TRACE("Channel put "<<SELF->channel->getChannelName());
+
+        PutOp::shared_pointer reqop(new PutOp(SELF));
+        reqop->cb.reset(cb, borrow());
+        reqop->pyvalue.reset(val, borrow());
+        reqop->req = buildRequest(req);
+
+        SELF->start(reqop);
+
+        if(timeout>0.0)
+            reqop->setDeadline(reqop, timeout);
+
         try {
             PyRef ret(PyOp::type.tp_new(&PyOp::type, args, kws));
 
@@ -725,8 +2125,7 @@ PyObject* Channel::py_put(PyObject *self, PyObject *args, PyObject *kws)
 
             return ret.release();
         }catch(...) {
-            reqop->op->destroy();
-            SELF->ops.erase(reqop);
+            reqop->cancel();
             throw;
         }
     }CATCH()
@@ -736,9 +2135,10 @@ PyObject* Channel::py_put(PyObject *self, PyObject *args, PyObject *kws)
 PyObject* Channel::py_rpc(PyObject *self, PyObject *args, PyObject *kws)
 {
     TRY {
-        static const char *names[] = {"callback", "value", "request", NULL};
+        static const char *names[] = {"callback", "value", "request", "timeout", NULL};
         PyObject *cb, *val, *req = Py_None;
-        if(!PyArg_ParseTupleAndKeywords(args, kws, "OO!|O", (char**)names, &cb, P4PValue_type, &val, &req))
+        double timeout = 0.0;
+        if(!PyArg_ParseTupleAndKeywords(args, kws, "OO!|Od", (char**)names, &cb, P4PValue_type, &val, &req, &timeout))
             return NULL;
 
         if(!PyCallable_Check(cb))
@@ -754,13 +2154,10 @@ PyObject* Channel::py_rpc(PyObject *self, PyObject *args, PyObject *kws)
         reqop->pvvalue = P4PValue_unwrap(val);
         reqop->req = buildRequest(req);
 
-        if(SELF->channel->isConnected()) {
-            TRACE("Issue rpc");
-            reqop->restart(reqop);
-        } else {
-            TRACE("Wait for connect");
-            SELF->ops.insert(reqop);
-        }
+        SELF->start(reqop);
+
+        if(timeout>0.0)
+            reqop->setDeadline(reqop, timeout);
 
         try {
             PyRef ret(PyOp::type.tp_new(&PyOp::type, args, kws));
@@ -769,8 +2166,7 @@ PyObject* Channel::py_rpc(PyObject *self, PyObject *args, PyObject *kws)
 
             return ret.release();
         }catch(...) {
-            reqop->op->destroy();
-            SELF->ops.erase(reqop);
+            reqop->cancel();
             throw;
         }
     }CATCH()
@@ -780,9 +2176,44 @@ PyObject* Channel::py_rpc(PyObject *self, PyObject *args, PyObject *kws)
 PyObject* Channel::py_monitor(PyObject *self, PyObject *args, PyObject *kws)
 {
     TRY {
-        static const char *names[] = {"callback", "request", NULL};
-        PyObject *cb, *req = Py_None;
-        if(!PyArg_ParseTupleAndKeywords(args, kws, "O|O", (char**)names, &cb, &req))
+        static const char *names[] = {"callback", "request", "borrow", "queueSize", "pipeline", "ackAny", "timeout", NULL};
+        PyObject *cb, *req = Py_None, *borrowelem = Py_False;
+        PyObject *queueSize = Py_None, *pipeline = Py_None, *ackAny = Py_None;
+        double timeout = 0.0;
+        if(!PyArg_ParseTupleAndKeywords(args, kws, "O|OOOOOd", (char**)names, &cb, &req, &borrowelem,
+                                        &queueSize, &pipeline, &ackAny, &timeout))
+            return NULL;
+
+        options_t opts;
+        if(queueSize!=Py_None) {
+            Py_ssize_t qsize = PyNumber_AsSsize_t(queueSize, PyExc_OverflowError);
+            if(qsize==-1 && PyErr_Occurred())
+                return NULL;
+            else if(qsize<=0)
+                return PyErr_Format(PyExc_ValueError, "queueSize must be positive");
+            opts["queueSize"] = SB()<<qsize;
+        }
+        if(pipeline!=Py_None) {
+            int P = PyObject_IsTrue(pipeline);
+            if(P<0)
+                return NULL;
+            opts["pipeline"] = P ? "true" : "false";
+        }
+        if(ackAny!=Py_None) {
+            // a count, or a percentage of queueSize (eg. "50%")
+            if(PyBytes_Check(ackAny) || PyUnicode_Check(ackAny)) {
+                opts["ackAny"] = PyString(ackAny).str();
+            } else {
+                Py_ssize_t N = PyNumber_AsSsize_t(ackAny, PyExc_OverflowError);
+                if(N==-1 && PyErr_Occurred())
+                    return NULL;
+                else if(N<=0)
+                    return PyErr_Format(PyExc_ValueError, "ackAny must be positive");
+                opts["ackAny"] = SB()<<N;
+            }
+        }
+        int B = PyObject_IsTrue(borrowelem);
+        if(B<0)
             return NULL;
 
         if(!PyCallable_Check(cb))
@@ -795,15 +2226,13 @@ PyObject* Channel::py_monitor(PyObject *self, PyObject *args, PyObject *kws)
 
         MonitorOp::shared_pointer reqop(new MonitorOp(SELF));
         reqop->event.reset(cb, borrow());
-        reqop->pvReq = buildRequest(req);
+        reqop->pvReq = requestOptions(buildRequest(req), opts);
+        reqop->borrow = B;
 
-        if(SELF->channel->isConnected()) {
-            TRACE("Issue monitor");
-            reqop->restart(reqop);
-        } else {
-            TRACE("Wait for connect");
-            SELF->ops.insert(reqop);
-        }
+        SELF->start(reqop);
+
+        if(timeout>0.0)
+            reqop->setDeadline(reqop, timeout);
 
         try {
             PyRef ret(PyOp::type.tp_new(&PyMonitorOp::type, args, kws));
@@ -812,14 +2241,107 @@ PyObject* Channel::py_monitor(PyObject *self, PyObject *args, PyObject *kws)
 
             return ret.release();
         }catch(...) {
-            reqop->op->destroy();
-            SELF->ops.erase(reqop);
+            reqop->cancel();
             throw;
         }
     }CATCH()
     return NULL;
 }
 
+PyObject* Channel::py_getter(PyObject *self, PyObject *args, PyObject *kws)
+{
+    TRY {
+        static const char *names[] = {"request", "recycle", NULL};
+        PyObject *req = Py_None, *recycle = Py_False;
+        if(!PyArg_ParseTupleAndKeywords(args, kws, "|OO", (char**)names, &req, &recycle))
+            return NULL;
+
+        if(!SELF->channel)
+            return PyErr_Format(PyExc_RuntimeError, "Channel closed");
+
+        int R = PyObject_IsTrue(recycle);
+        if(R<0)
+            return NULL;
+
+        GetterOp::shared_pointer reqop(new GetterOp(SELF));
+        reqop->req = buildRequest(req);
+        reqop->recycle = R;
+
+        PyRef ret(PyGetter::type.tp_new(&PyGetter::type, args, kws));
+
+        PyGetter::unwrap(ret.get()) = reqop;
+
+        SELF->start(reqop);
+
+        return ret.release();
+    }CATCH()
+    return NULL;
+}
+
+PyObject* Channel::py_type(PyObject *self, PyObject *args, PyObject *kws)
+{
+    TRY {
+        static const char *names[] = {"callback", NULL};
+        PyObject *cb = Py_None;
+        if(!PyArg_ParseTupleAndKeywords(args, kws, "|O", (char**)names, &cb))
+            return NULL;
+
+        if(!SELF->channel)
+            return PyErr_Format(PyExc_RuntimeError, "Channel closed");
+
+        if(cb==Py_None) {
+            pvd::StructureConstPtr T;
+            {
+                Guard G(SELF->lock);
+                T = SELF->fieldType;
+            }
+            if(!T)
+                Py_RETURN_NONE;
+            return P4PType_wrap(P4PType_type, T);
+        }
+
+        if(!PyCallable_Check(cb))
+            return PyErr_Format(PyExc_ValueError, "callable required, not %s", Py_TYPE(cb)->tp_name);
+
+        TypeOp::shared_pointer reqop(new TypeOp(SELF));
+        reqop->cb.reset(cb, borrow());
+
+        PyRef ret(PyOp::type.tp_new(&PyOp::type, args, kws));
+
+        PyOp::unwrap(ret.get()) = reqop;
+
+        SELF->start(reqop);
+
+        return ret.release();
+    }CATCH()
+    return NULL;
+}
+
+PyObject* Channel::py_putter(PyObject *self, PyObject *args, PyObject *kws)
+{
+    TRY {
+        static const char *names[] = {"request", NULL};
+        PyObject *req = Py_None;
+        if(!PyArg_ParseTupleAndKeywords(args, kws, "|O", (char**)names, &req))
+            return NULL;
+
+        if(!SELF->channel)
+            return PyErr_Format(PyExc_RuntimeError, "Channel closed");
+
+        PutterOp::shared_pointer reqop(new PutterOp(SELF));
+        reqop->req = buildRequest(req);
+
+        PyRef ret(PyPutter::type.tp_new(&PyPutter::type, args, kws));
+
+        PyPutter::unwrap(ret.get()) = reqop;
+
+        SELF->start(reqop);
+
+        return ret.release();
+    }CATCH()
+    return NULL;
+}
+
 PyObject* Channel::py_name(PyObject *self)
 {
     TRY {
@@ -835,19 +2357,44 @@ PyObject *Channel::py_close(PyObject *self)
 {
     TRY {
         if(SELF->channel) {
-            pva::Channel::shared_pointer chan;
-            SELF->channel.swap(chan);
-            {
-                PyUnlock U;
-                chan->destroy();
-                chan.reset();
-            }
+            // release our handle to the pooled Channel, which may still
+            // be in use by others, or by our operations.
+            Channel::shared_pointer closed(new Channel);
+            SELF.swap(closed);
         }
         Py_RETURN_NONE;
     }CATCH();
     return NULL;
 }
 
+PyObject *Channel::py_convert(PyObject *self, PyObject *args, PyObject *kws)
+{
+    TRY {
+        static const char *names[] = {"value", "type", "changed", NULL};
+        PyObject *val, *type, *changed = Py_False;
+        if(!PyArg_ParseTupleAndKeywords(args, kws, "O!O!|O", (char**)names, P4PValue_type, &val,
+                                        P4PType_type, &type, &changed))
+            return NULL;
+        int C = PyObject_IsTrue(changed);
+        if(C<0)
+            return NULL;
+
+        pvd::PVStructure::shared_pointer src(P4PValue_unwrap(val));
+        pvd::StructureConstPtr dest(P4PType_unwrap(type));
+        pvd::BitSet::shared_pointer smask;
+        if(C)
+            smask = P4PValue_unwrap_bitset(val);
+
+        pvd::PVStructure::shared_pointer conv(pvd::getPVDataCreate()->createPVStructure(dest));
+        pvd::BitSet::shared_pointer dmask(new pvd::BitSet);
+
+        SELF->plan(src->getStructure(), dest)->apply(src, smask.get(), conv, *dmask);
+
+        return P4PValue_wrap(P4PValue_type, conv, dmask);
+    }CATCH()
+    return NULL;
+}
+
 void Channel::Req::channelCreated(const pvd::Status& status, pva::Channel::shared_pointer const & channel)
 {
     //TODO: can/do client contexts signal any errors here?
@@ -858,74 +2405,179 @@ void Channel::Req::channelCreated(const pvd::Status& status, pva::Channel::share
     (void)channel;
 }
 
+// the Channel has (dis)connected, or been destroyed, while it had operations
+struct StateChange : public Dispatcher::Work {
+    Channel::shared_pointer chan;
+    unsigned gen;
+    pva::Channel::ConnectionState state;
+    StateChange(const Channel::shared_pointer& chan, unsigned gen, pva::Channel::ConnectionState state)
+        :chan(chan), gen(gen), state(state) {}
+    virtual ~StateChange() {}
+    virtual void run() { chan->stateChanged(gen, state); }
+};
+
 void Channel::Req::channelStateChange(pva::Channel::shared_pointer const & channel, pva::Channel::ConnectionState connectionState)
 {
     Channel::shared_pointer op(owner.lock());
     if(!op)
         return;
-    PyLock L;
-    TRACE(channel->getChannelName()<<" "<<connectionState<<" #ops="<<op->ops.size());
+    TRACE(channel->getChannelName()<<" "<<connectionState);
     switch(connectionState) {
     case pva::Channel::NEVER_CONNECTED:
-        break; // should never happen
+        return; // should never happen
     case pva::Channel::CONNECTED:
-    {
-        operations_t temp;
-        temp.swap(op->ops);
-
-        for(operations_t::const_iterator it = temp.begin(), end = temp.end(); it!=end; ++it) {
-            TRACE("CONN "<<(*it));
-            if(!(*it)) continue; // shouldn't happen, but guard against it anyway
-            TRACE("CONN2 "<<(*it)<<" refs="<<it->use_count());
-            try {
-                (*it)->restart(*it);
-                // restart() should re-add itself to ops
-            } catch(std::exception& e) {
-                std::cout<<"Error in restart() "<<e.what()<<"\n";
-            }
-        }
-    }
-        return;
     case pva::Channel::DISCONNECTED:
-    {
-        operations_t temp;
-        temp.swap(op->ops);
-        for(operations_t::const_iterator it = temp.begin(), end = temp.end(); it!=end; ++it) {
-            if(!(*it)) continue; // shouldn't happen, but guard against it anyway
-            try {
-                (*it)->lostConn(*it);
-            } catch(std::exception& e) {
-                std::cout<<"Error in cancel() "<<e.what()<<"\n";
-            }
-        }
-    }
-        return;
     case pva::Channel::DESTROYED:
-    {
-        operations_t temp;
-        temp.swap(op->ops);
-        for(operations_t::const_iterator it = temp.begin(), end = temp.end(); it!=end; ++it) {
-            if(!(*it)) continue; // shouldn't happen, but guard against it anyway
-            try {
-                (*it)->cancel();
-            } catch(std::exception& e) {
-                std::cout<<"Error in cancel() "<<e.what()<<"\n";
-            }
-        }
-    }
+        break;
+    default:
+        std::cerr<<"channelStateChange(\""<<channel->getChannelName()<<"\", "<<connectionState<<") unexpected state\n";
         return;
     }
-    std::cerr<<"channelStateChange(\""<<channel->getChannelName()<<"\", "<<connectionState<<") unexpected state\n";
-}
 
+    unsigned gen;
+    bool idle;
+    waiters_t wake;
+    {
+        Guard G(op->lock);
+        // may be a different server
+        op->fieldType.reset();
+        gen = ++op->connGen;
+        op->connected = connectionState==pva::Channel::CONNECTED;
+        if(op->connected)
+            wake.swap(op->waiters);
+        idle = op->ops.empty();
+        if(idle)
+            op->opsGen = gen;
+    }
 
-#undef TRY
-#define TRY PyOp::reference_type SELF = PyOp::unwrap(self); try
+    for(waiters_t::const_iterator it(wake.begin()), end(wake.end()); it!=end; ++it)
+        it->first->finish(it->second, pvd::Status(), pvd::PVStructure::shared_pointer());
 
-PyObject* OpBase::py_cancel(PyObject *self)
-{
-    TRY {
-        bool cancelled = SELF->channel.get() && SELF->cancel();
+    if(idle)
+        return; // nothing to do, so no need for the GIL
+
+    Dispatcher::Work::shared_pointer work(new StateChange(op, gen, connectionState));
+    // Operations are cancelled before destroy() returns.
+    // Otherwise, through the Dispatcher, in order with other callbacks of this Channel.
+    if(connectionState!=pva::Channel::DESTROYED && op->dispatch && op->dispatch->push(size_t(op.get()), work))
+        return;
+    PyLock L;
+    Dispatcher::call(*work);
+}
+
+void Channel::start(const Op::shared_pointer& op)
+{
+    bool now;
+    {
+        Guard G(lock);
+        // in case of a state change before restart() re-adds
+        ops.insert(op);
+        // otherwise a pending stateChanged() will restart()
+        now = connected && opsGen==connGen;
+    }
+    TRACE((now ? "Issue" : "Wait for connect"));
+    if(now)
+        op->restart(op);
+}
+
+void Channel::stateChanged(unsigned gen, pva::Channel::ConnectionState state)
+{
+    operations_t temp;
+    {
+        Guard G(lock);
+        if(gen!=connGen)
+            return; // superseded by a later change, which is also pending
+        opsGen = gen;
+        temp.swap(ops);
+    }
+    TRACE("gen="<<gen<<" state="<<state<<" #ops="<<temp.size());
+
+    for(operations_t::const_iterator it = temp.begin(), end = temp.end(); it!=end; ++it) {
+        if(!(*it)) continue; // shouldn't happen, but guard against it anyway
+        try {
+            switch(state) {
+            case pva::Channel::CONNECTED:
+                // restart() should re-add itself to ops
+                (*it)->restart(*it);
+                break;
+            case pva::Channel::DISCONNECTED:
+                (*it)->lostConn(*it);
+                break;
+            default:
+                (*it)->cancel();
+                break;
+            }
+        } catch(std::exception& e) {
+            std::cout<<"Error in state change "<<state<<" "<<e.what()<<"\n";
+        }
+    }
+}
+
+struct OpDone : public Dispatcher::Work {
+    OpBase::shared_pointer op;
+    pvd::Status status;
+    pvd::PVStructure::shared_pointer value;
+    OpDone(const OpBase::shared_pointer& op, const pvd::Status& status, const pvd::PVStructure::shared_pointer& value)
+        :op(op), status(status), value(value) {}
+    virtual ~OpDone() {}
+    virtual void run() { op->done(status, value); }
+};
+
+void OpBase::complete(const OpBase::shared_pointer& op, const pvd::Status& sts, const pvd::PVStructure::shared_pointer& val)
+{
+    if(op->bulk) {
+        op->bulk->finish(op->bulkIndex, sts, val);
+        return;
+    }
+    op->defer(Dispatcher::Work::shared_pointer(new OpDone(op, sts, val)));
+}
+
+void OpBase::done(const pvd::Status& sts, const pvd::PVStructure::shared_pointer& val)
+{
+    if(!cb.get())
+        return; // cancelled
+    PyRef V;
+
+    if(!sts.isSuccess()) {
+        // build Exception instance
+        // TODO: create RemoteError type
+        V.reset(PyObject_CallFunction(PyExc_RuntimeError, (char*)"s", sts.getMessage().c_str()));
+    } else if(val) {
+        // we don't re-use operations, so assume exclusive ownership of val w/o a copy
+        V.reset(P4PValue_wrap(P4PValue_type, val));
+    } else {
+        V.reset(Py_None, borrow());
+    }
+
+    if(!V.get()) {
+        PyErr_Print();
+        PyErr_Clear();
+        std::cerr<<"Error in operation completion\n";
+    } else {
+        call_cb(V.get());
+    }
+}
+
+void OpBase::expire()
+{
+    if(!deadline || !cb.get())
+        return; // completed, or cancelled, while queued
+    PyRef temp(cb);
+    // release the pva::Channel* operation now, not when the Operation is collected
+    cancel();
+    cb.swap(temp);
+
+    PyRef err(PyObject_CallFunction(P4PTimeout, "s", "Timeout"));
+    call_cb(err.get());
+}
+
+#undef TRY
+#define TRY PyOp::reference_type SELF = PyOp::unwrap(self); try
+
+PyObject* OpBase::py_cancel(PyObject *self)
+{
+    TRY {
+        bool cancelled = SELF->channel.get() && SELF->cancel();
 
         return PyBool_FromLong(cancelled);
     } CATCH()
@@ -961,6 +2613,64 @@ int OpBase::py_clear(PyObject *self)
 }
 
 
+void MonitorOp::Event::run()
+{
+    TRACE("kind="<<kind<<" status="<<status);
+    switch(kind) {
+    case Connect:
+        op->clearDeadline();
+        if(op->done)
+            return;
+        if(status.isSuccess()) {
+            op->type = type;
+            monitor->start();
+            op->empty = true;
+        } else {
+            PyRef err(PyObject_CallFunction(PyExc_RuntimeError, "s", status.getMessage().c_str()));
+            op->call_cb(err.get());
+            op->event.reset();
+        }
+        break;
+    case Update: {
+        op->empty = false;
+        PyRef val(Py_None, borrow());
+        if(!op->call_cb(val.get())) {
+            // the wakeup was lost, so no poll() may follow.
+            // Re-arm, or the next update would not notify either.
+            Guard G(op->lock);
+            op->notified = false;
+        }
+        break;
+    }
+    case Unlisten: {
+        op->done = true;
+        PyRef val(Py_None, borrow());
+        op->call_cb(val.get());
+        Selector::shared_pointer sel;
+        {
+            Guard G(op->lock);
+            sel = op->selector;
+        }
+        if(sel)
+            sel->post(op);
+        break;
+    }
+    }
+}
+
+void MonitorOp::expire()
+{
+    if(!deadline || done || !event.get())
+        return; // connected, or closed, while queued
+    PyRef temp(event);
+    cancel();
+    event.swap(temp);
+
+    PyRef err(PyObject_CallFunction(P4PTimeout, "s", "Timeout"));
+    call_cb(err.get());
+    event.reset();
+}
+
 #undef TRY
 #define TRY PyMonitorOp::reference_type SELF = PyMonitorOp::unwrap(self); try
 
@@ -969,6 +2679,13 @@ PyObject *MonitorOp::py_close(PyObject *self)
     TRY {
         TRACE("cancel subscription");
         SELF->event.reset();
+        Selector::shared_pointer sel;
+        {
+            Guard G(SELF->lock);
+            sel.swap(SELF->selector);
+        }
+        if(sel)
+            sel->subs.erase(SELF.get());
         pva::Monitor::shared_pointer op;
         SELF->op.swap(op);
         if(op) {
@@ -1009,41 +2726,315 @@ PyObject *MonitorOp::py_done(PyObject *self)
     return NULL;
 }
 
+PyObject *MonitorOp::pop()
+{
+    if(!op)
+        return NULL;
+
+    pva::MonitorElementPtr elem(poll());
+    empty = !elem;
+    if(!elem) {
+        TRACE("Empty");
+        return NULL;
+    }
+    if(borrow) {
+        // element returned to the Monitor when the Value, and any sub-structure Values, are collected
+        ElementPin *P;
+        try {
+            P = new ElementPin(op, elem);
+        } catch(...) {
+            op->release(elem);
+            throw;
+        }
+        std::tr1::shared_ptr<void> pin(P);
+        pvd::BitSet::shared_pointer O(account(elem));
+
+        pvd::BitSet::shared_pointer M;
+        if(elem->changedBitSet) {
+            M.reset(new pvd::BitSet);
+            *M = *elem->changedBitSet;
+        }
+
+        TRACE("event="<<elem->pvStructurePtr);
+        PyRef ret(P4PValue_wrap(P4PValue_type, elem->pvStructurePtr, M, pin));
+        if(O)
+            P4PValue_set_overrun(ret.get(), O);
+        return ret.release();
+    }
+    try {
+
+        pvd::PVStructure::shared_pointer& E = elem->pvStructurePtr;
+
+        pvd::PVStructure::shared_pointer V(pvd::getPVDataCreate()->createPVStructure(E->getStructure()));
+        V->copyUnchecked(*E);
+
+        pvd::BitSet::shared_pointer M;
+        if(elem->changedBitSet) {
+            M.reset(new pvd::BitSet);
+            *M = *elem->changedBitSet;
+        }
+        pvd::BitSet::shared_pointer O(account(elem));
+
+        op->release(elem);
+
+        TRACE("event="<<V);
+        PyRef ret(P4PValue_wrap(P4PValue_type, V, M));
+        if(O)
+            P4PValue_set_overrun(ret.get(), O);
+        return ret.release();
+    } catch(...){
+        op->release(elem);
+        throw;
+    }
+}
+
 PyObject *MonitorOp::py_pop(PyObject *self)
 {
     TRY {
-        if(!SELF->op)
+        PyObject *ret = SELF->pop();
+        if(!ret)
             Py_RETURN_NONE;
+        return ret;
+    }CATCH()
+    return NULL;
+}
 
-        pva::MonitorElementPtr elem(SELF->op->poll());
-        SELF->empty = !elem;
-        if(!elem) {
-            TRACE("Empty");
-            Py_RETURN_NONE;
+PyObject *MonitorOp::py_pop_many(PyObject *self, PyObject *args, PyObject *kws)
+{
+    TRY {
+        static const char *names[] = {"max", NULL};
+        Py_ssize_t nmax = 0;
+        if(!PyArg_ParseTupleAndKeywords(args, kws, "|n", (char**)names, &nmax))
+            return NULL;
+
+        PyRef ret(PyList_New(0));
+
+        for(Py_ssize_t n=0; nmax<=0 || n<nmax; n++) {
+            PyRef val(SELF->pop(), allownull());
+            if(!val.get())
+                break;
+            if(PyList_Append(ret.get(), val.get()))
+                return NULL;
         }
-        try {
 
-            pvd::PVStructure::shared_pointer& E = elem->pvStructurePtr;
+        return ret.release();
+    }CATCH()
+    return NULL;
+}
+
+template<typename T>
+void fill_column(void *dest, const std::vector<pva::MonitorElementPtr>& elems, size_t offset)
+{
+    T *D = static_cast<T*>(dest);
+    for(size_t i=0; i<elems.size(); i++) {
+        D[i] = static_cast<pvd::PVScalarValue<T>*>(elems[i]->pvStructurePtr->getSubFieldT(offset).get())->get();
+    }
+}
 
-            pvd::PVStructure::shared_pointer V(pvd::getPVDataCreate()->createPVStructure(E->getStructure()));
-            V->copyUnchecked(*E);
+// return elements to the Monitor when leaving scope
+struct ElementsRelease {
+    const pva::Monitor::shared_pointer& mon;
+    std::vector<pva::MonitorElementPtr>& elems;
+    ElementsRelease(const pva::Monitor::shared_pointer& mon, std::vector<pva::MonitorElementPtr>& elems)
+        :mon(mon), elems(elems) {}
+    ~ElementsRelease() {
+        for(size_t i=0; i<elems.size(); i++)
+            mon->release(elems[i]);
+    }
+};
 
-            pvd::BitSet::shared_pointer M;
-            if(elem->changedBitSet) {
-                M.reset(new pvd::BitSet);
-                *M = *elem->changedBitSet;
+// A scalar field of a pop_columns() batch
+struct Column {
+    std::string name;
+    pvd::ScalarType stype;
+    // of the field, and of each enclosing structure.  From an element, so empty if none
+    std::vector<size_t> offsets;
+};
+
+// resolve against the structure of an element.  false if not a scalar field
+bool find_column(Column& col, pvd::PVStructure& elem)
+{
+    pvd::PVScalarPtr fld(elem.getSubField<pvd::PVScalar>(col.name));
+    if(!fld)
+        return false;
+    col.stype = fld->getScalar()->getScalarType();
+    col.offsets.push_back(fld->getFieldOffset());
+    for(pvd::PVStructure *parent = fld->getParent(); parent; parent = parent->getParent())
+        col.offsets.push_back(parent->getFieldOffset());
+    return true;
+}
+
+// resolve against a type, with no element.  false if not a scalar field
+bool find_column(Column& col, const pvd::Structure *type)
+{
+    const pvd::Field *fld = type;
+    size_t start = 0, sep;
+    do {
+        if(fld->getType()!=pvd::structure)
+            return false;
+        sep = col.name.find('.', start);
+        fld = static_cast<const pvd::Structure*>(fld)->getField(col.name.substr(start, sep==col.name.npos ? sep : sep-start)).get();
+        start = sep+1;
+    } while(fld && sep!=col.name.npos);
+    if(!fld || fld->getType()!=pvd::scalar)
+        return false;
+    col.stype = static_cast<const pvd::Scalar*>(fld)->getScalarType();
+    return true;
+}
+
+PyObject *MonitorOp::py_pop_columns(PyObject *self, PyObject *args, PyObject *kws)
+{
+    TRY {
+        static const char *names[] = {"fields", "max", "overrun", NULL};
+        PyObject *fields, *overrun = Py_False;
+        Py_ssize_t nmax = 0;
+        if(!PyArg_ParseTupleAndKeywords(args, kws, "O|nO", (char**)names, &fields, &nmax, &overrun))
+            return NULL;
+
+        int wantO = PyObject_IsTrue(overrun);
+        if(wantO<0)
+            return NULL;
+
+        std::vector<Column> cols;
+        {
+            PyRef iter(PyObject_GetIter(fields));
+            while(true) {
+                PyRef F(PyIter_Next(iter.get()), allownull());
+                if(!F.get()) {
+                    if(PyErr_Occurred())
+                        return NULL;
+                    break;
+                }
+                cols.push_back(Column());
+                cols.back().name = PyString(F.get()).str();
+            }
+        }
+
+        pva::Monitor::shared_pointer mon(SELF->op);
+        std::vector<pva::MonitorElementPtr> elems;
+        ElementsRelease R(mon, elems);
+
+        // check every name against the first update, before taking any others.
+        // When there is none, against the type of the subscription, if connected.
+        pva::MonitorElementPtr first;
+        if(mon)
+            first = SELF->poll();
+
+        pvd::StructureConstPtr type(first ? first->pvStructurePtr->getStructure() : SELF->type);
+
+        for(size_t f=0; f<cols.size(); f++) {
+            bool ok;
+            if(first)
+                ok = find_column(cols[f], *first->pvStructurePtr);
+            else
+                ok = !type || find_column(cols[f], type.get());
+            if(!ok) {
+                // not consumed.  Returned by the next pop()
+                SELF->empty = !first;
+                SELF->held.swap(first);
+                return PyErr_Format(PyExc_KeyError, "No scalar field %s", cols[f].name.c_str());
             }
-            // TODO: overrunBitSet??
+        }
 
-            SELF->op->release(elem);
+        bool drained = !first;
+        if(first) {
+            elems.push_back(first);
+            SELF->account(first);
 
-            TRACE("event="<<V);
-            return P4PValue_wrap(P4PValue_type, V, M);
-        } catch(...){
-            SELF->op->release(elem);
-            throw;
+            while(nmax<=0 || elems.size()<size_t(nmax)) {
+                pva::MonitorElementPtr elem(SELF->poll());
+                if(!elem) {
+                    drained = true;
+                    break;
+                }
+                if(elem->pvStructurePtr->getStructure()!=type) {
+                    // type changed (reconnect).  This update begins the next batch
+                    SELF->held.swap(elem);
+                    break;
+                }
+                elems.push_back(elem);
+                SELF->account(elem);
+            }
+        }
+        SELF->empty = drained;
+
+        PyRef ret(PyDict_New());
+        PyRef over(PyDict_New());
+
+        for(size_t f=0; f<cols.size(); f++) {
+            const Column& C = cols[f];
+            PyRef col;
+
+            if(!type) {
+                // never connected, so the field types are not known
+                col.reset(PyList_New(0));
+
+            } else if(C.stype==pvd::pvString) {
+                col.reset(PyList_New(elems.size()));
+                for(size_t i=0; i<elems.size(); i++) {
+                    const std::string& S = static_cast<pvd::PVString*>(elems[i]->pvStructurePtr->getSubFieldT(C.offsets[0]).get())->get();
+                    PyRef str(PyUnicode_FromStringAndSize(S.c_str(), S.size()));
+                    PyList_SET_ITEM(col.get(), i, str.release());
+                }
+
+            } else {
+                pvd::shared_vector<void> buf(P4PArray_alloc(C.stype, elems.size()));
+
+                if(!elems.empty()) {
+                    size_t offset = C.offsets[0];
+                    switch(C.stype) {
+                    case pvd::pvBoolean: fill_column<pvd::boolean>(buf.data(), elems, offset); break;
+                    case pvd::pvByte:    fill_column<pvd::int8>(buf.data(), elems, offset); break;
+                    case pvd::pvShort:   fill_column<pvd::int16>(buf.data(), elems, offset); break;
+                    case pvd::pvInt:     fill_column<pvd::int32>(buf.data(), elems, offset); break;
+                    case pvd::pvLong:    fill_column<pvd::int64>(buf.data(), elems, offset); break;
+                    case pvd::pvUByte:   fill_column<pvd::uint8>(buf.data(), elems, offset); break;
+                    case pvd::pvUShort:  fill_column<pvd::uint16>(buf.data(), elems, offset); break;
+                    case pvd::pvUInt:    fill_column<pvd::uint32>(buf.data(), elems, offset); break;
+                    case pvd::pvULong:   fill_column<pvd::uint64>(buf.data(), elems, offset); break;
+                    case pvd::pvFloat:   fill_column<float>(buf.data(), elems, offset); break;
+                    case pvd::pvDouble:  fill_column<double>(buf.data(), elems, offset); break;
+                    default:
+                        throw std::logic_error("unreachable");
+                    }
+                }
+
+                col.reset(P4PValue_ndarray(pvd::freeze(buf)));
+            }
+
+            if(PyDict_SetItemString(ret.get(), C.name.c_str(), col.get()))
+                return NULL;
+
+            if(wantO) {
+                // as Value.overrun(field).  the field, or an enclosing structure
+                pvd::shared_vector<void> obuf(P4PArray_alloc(pvd::pvBoolean, elems.size()));
+                pvd::boolean *O = static_cast<pvd::boolean*>(obuf.data());
+                for(size_t i=0; i<elems.size(); i++) {
+                    const pvd::BitSet::shared_pointer& B = elems[i]->overrunBitSet;
+                    O[i] = 0;
+                    for(size_t j=0; B && j<C.offsets.size() && !O[i]; j++)
+                        O[i] = B->get(C.offsets[j]);
+                }
+                PyRef ocol(P4PValue_ndarray(pvd::freeze(obuf)));
+                if(PyDict_SetItemString(over.get(), C.name.c_str(), ocol.get()))
+                    return NULL;
+            }
         }
 
+        if(wantO)
+            return Py_BuildValue("OO", ret.get(), over.get());
+        return ret.release();
+    }CATCH()
+    return NULL;
+}
+
+PyObject *MonitorOp::py_stats(PyObject *self)
+{
+    TRY {
+        return Py_BuildValue("{snsnsn}",
+                             "updates", Py_ssize_t(SELF->nUpdates),
+                             "overruns", Py_ssize_t(SELF->nOverruns),
+                             "maxdepth", Py_ssize_t(SELF->maxDepth));
     }CATCH()
     return NULL;
 }
@@ -1069,139 +3060,1287 @@ int MonitorOp::py_clear(PyObject *self)
 }
 
 
-void GetOp::restart(const Channel::Op::shared_pointer& self)
+Selector::Selector()
+    :signaled(false)
+    ,rfd(-1)
+    ,wfd(-1)
 {
-    TRACE("channel="<<channel.get()<<" refs="<<self.use_count());
-    if(!channel) return;
-    pva::ChannelGet::shared_pointer temp;
-    GetOp::Req::shared_pointer pyreq(new GetOp::Req(std::tr1::static_pointer_cast<GetOp>(self)));
-    temp.swap(op);
-    {
-        PyUnlock U;
-        if(temp)
-            temp->destroy();
-
-        temp = channel->channel->createChannelGet(pyreq, req);
-        TRACE("start get "<<temp<<" refs="<<self.use_count()<<" req="<<req);
+#if defined(__linux__)
+    rfd = wfd = eventfd(0, EFD_NONBLOCK|EFD_CLOEXEC);
+    if(rfd<0)
+        throw std::runtime_error(SB()<<"eventfd() error "<<errno);
+#elif !defined(_WIN32)
+    int fds[2];
+    if(pipe(fds))
+        throw std::runtime_error(SB()<<"pipe() error "<<errno);
+    for(unsigned i=0; i<2; i++) {
+        fcntl(fds[i], F_SETFL, fcntl(fds[i], F_GETFL)|O_NONBLOCK);
+        fcntl(fds[i], F_SETFD, FD_CLOEXEC);
     }
-    op = temp;
-    channel->ops.insert(self);
+    rfd = fds[0];
+    wfd = fds[1];
+#else
+    throw std::runtime_error("Selector not implemented for this target");
+#endif
 }
 
-void GetOp::lostConn(const Channel::Op::shared_pointer &self)
+void Selector::post(const std::tr1::shared_ptr<MonitorOp>& op)
 {
-    if(channel)
-        channel->ops.insert(self);
-    if(op) {
-        pva::ChannelGet::shared_pointer temp;
-        temp.swap(op);
-
-        PyUnlock U;
-
-        temp->destroy();
-        temp.reset();
-    }
+    Guard G(lock);
+    if(rfd<0)
+        return;
+    pending.push_back(op);
+    if(signaled)
+        return;
+    signaled = true;
+#if defined(__linux__)
+    uint64_t one = 1;
+    if(write(wfd, &one, sizeof(one))!=sizeof(one)) {}
+#elif !defined(_WIN32)
+    char one = 1;
+    if(write(wfd, &one, 1)!=1) {}
+#endif
 }
 
-bool GetOp::cancel()
+void Selector::close()
 {
-    bool canceled = OpBase::cancel();
-
-    if(op) {
-        canceled = true;
-        pva::ChannelGet::shared_pointer temp;
-        temp.swap(op);
-
-        PyUnlock U;
+    Guard G(lock);
+    pending.clear();
+#if !defined(_WIN32)
+    if(rfd>=0)
+        ::close(rfd);
+    if(wfd>=0 && wfd!=rfd)
+        ::close(wfd);
+#endif
+    rfd = wfd = -1;
+}
 
-        TRACE("destroy ChannelGet");
-        temp->destroy();
+#undef TRY
+#define TRY PySelector::reference_type SELF = PySelector::unwrap(self); try
 
-        if(!temp.unique()) {
-            TRACE("remaining refs="<<temp.use_count());
-        }
+int Selector::py_init(PyObject *self, PyObject *args, PyObject *kws)
+{
+    TRY {
+        static const char *names[] = {NULL};
+        if(!PyArg_ParseTupleAndKeywords(args, kws, "", (char**)names))
+            return -1;
 
-        temp.reset();
-    }
+        if(!SELF)
+            SELF.reset(new Selector);
 
-    return canceled;
+        return 0;
+    }CATCH()
+    return -1;
 }
 
-void GetOp::Req::channelGetConnect(
-    const pvd::Status& status,
-    pva::ChannelGet::shared_pointer const & channelGet,
-    pvd::Structure::const_shared_pointer const & structure)
+PyObject *Selector::py_fileno(PyObject *self)
 {
-    GetOp::shared_pointer op(owner.lock());
-    if(!op)
-        return;
-
-    TRACE("get start "<<channelGet->getChannel()->getChannelName()<<" "<<status);
-    if(!status.isSuccess()) {
-        PyLock L;
-        PyRef E(PyObject_CallFunction(PyExc_RuntimeError, (char*)"s", status.getMessage().c_str()));
-        op->call_cb(E.get());
-    } else {
-        channelGet->lastRequest();
-        // may call getDone() recursively
-        channelGet->get();
-    }
+    TRY {
+        if(!SELF || SELF->rfd<0)
+            return PyErr_Format(PyExc_ValueError, "Selector closed");
+        return PyLong_FromLong(SELF->rfd);
+    }CATCH()
+    return NULL;
 }
 
-void GetOp::Req::getDone(
-    const pvd::Status& status,
-    pva::ChannelGet::shared_pointer const & channelGet,
-    pvd::PVStructure::shared_pointer const & pvStructure,
-    pvd::BitSet::shared_pointer const & bitSet)
+PyObject *Selector::py_add(PyObject *self, PyObject *args)
 {
-    GetOp::shared_pointer op(owner.lock());
-    if(!op)
-        return;
-    PyLock L;
+    TRY {
+        PyObject *sub;
+        if(!PyArg_ParseTuple(args, "O!", &PyMonitorOp::type, &sub))
+            return NULL;
+        if(!SELF || SELF->rfd<0)
+            return PyErr_Format(PyExc_ValueError, "Selector closed");
 
-    TRACE("get complete "<<channelGet->getChannel()->getChannelName()<<" for "<<op->cb.get()<<" with "<<status);
-    if(!op->cb.get()) return;
-    PyRef V;
+        MonitorOp::shared_pointer op(PyMonitorOp::unwrap(sub));
+        if(!op)
+            return PyErr_Format(PyExc_ValueError, "Subscription closed");
 
-    if(status.isSuccess()) {
-        // we don't re-use ChannelGet, so assume exclusive ownership of pvStructure w/o a copy
-        V.reset(P4PValue_wrap(P4PValue_type, pvStructure));
+        {
+            Guard G(op->lock);
+            if(op->selector && op->selector!=SELF)
+                return PyErr_Format(PyExc_ValueError, "Subscription already added to another Selector");
+            op->selector = SELF;
+        }
+        SELF->subs[op.get()].reset(sub, borrow());
+
+        // updates may already be queued, with 'event' already notified
+        SELF->post(op);
+
+        Py_RETURN_NONE;
+    }CATCH()
+    return NULL;
+}
+
+PyObject *Selector::py_remove(PyObject *self, PyObject *args)
+{
+    TRY {
+        PyObject *sub;
+        if(!PyArg_ParseTuple(args, "O!", &PyMonitorOp::type, &sub))
+            return NULL;
+
+        MonitorOp::shared_pointer op(PyMonitorOp::unwrap(sub));
+        if(op && SELF) {
+            {
+                Guard G(op->lock);
+                if(op->selector==SELF)
+                    op->selector.reset();
+            }
+            SELF->subs.erase(op.get());
+        }
+
+        Py_RETURN_NONE;
+    }CATCH()
+    return NULL;
+}
+
+PyObject *Selector::py_ready(PyObject *self)
+{
+    TRY {
+        PyRef ret(PyList_New(0));
+        if(!SELF)
+            return ret.release();
+
+        std::vector<std::tr1::weak_ptr<MonitorOp> > ready;
+        {
+            Guard G(SELF->lock);
+            ready.swap(SELF->pending);
+
+            if(SELF->signaled && SELF->rfd>=0) {
+                SELF->signaled = false;
+#if !defined(_WIN32)
+                char junk[64];
+                while(read(SELF->rfd, junk, sizeof(junk))>0) {}
+#endif
+            }
+        }
+
+        std::set<MonitorOp*> seen;
+
+        for(size_t i=0; i<ready.size(); i++) {
+            MonitorOp::shared_pointer op(ready[i].lock());
+            if(!op || !seen.insert(op.get()).second)
+                continue;
+
+            subs_t::const_iterator it(SELF->subs.find(op.get()));
+            if(it==SELF->subs.end())
+                continue; // removed
+
+            op->empty = false;
+
+            if(PyList_Append(ret.get(), it->second.get()))
+                return NULL;
+        }
+
+        return ret.release();
+    }CATCH()
+    return NULL;
+}
+
+PyObject *Selector::py_close(PyObject *self)
+{
+    TRY {
+        if(SELF) {
+            for(subs_t::const_iterator it(SELF->subs.begin()), end(SELF->subs.end()); it!=end; ++it) {
+                MonitorOp *op = it->first;
+                Guard G(op->lock);
+                if(op->selector==SELF)
+                    op->selector.reset();
+            }
+            subs_t trash;
+            SELF->subs.swap(trash);
+            SELF->close();
+        }
+        Py_RETURN_NONE;
+    }CATCH()
+    return NULL;
+}
+
+int Selector::py_traverse(PyObject *self, visitproc visit, void *arg)
+{
+    TRY {
+        if(SELF) {
+            for(subs_t::const_iterator it(SELF->subs.begin()), end(SELF->subs.end()); it!=end; ++it)
+                Py_VISIT(it->second.get());
+        }
+        return 0;
+    }CATCH()
+    return -1;
+}
+
+int Selector::py_clear(PyObject *self)
+{
+    TRY {
+        if(SELF) {
+            subs_t trash;
+            SELF->subs.swap(trash);
+        }
+        return 0;
+    }CATCH()
+    return -1;
+}
+
+bool Dispatcher::Worker::push(const Work::shared_pointer& work)
+{
+    bool wake;
+    {
+        Guard G(lock);
+        if(!running)
+            return false;
+        // otherwise already signaled, and not yet woken
+        wake = queue.empty();
+        queue.push_back(work);
+        if(maxdepth < queue.size())
+            maxdepth = queue.size();
+    }
+    if(wake)
+        wakeup.signal();
+    return true;
+}
+
+void Dispatcher::Worker::run(void *raw)
+{
+    Worker::shared_pointer self;
+    {
+        Worker::shared_pointer *arg = static_cast<Worker::shared_pointer*>(raw);
+        self.swap(*arg);
+        delete arg;
+    }
+
+    std::deque<Work::shared_pointer> batch;
+    while(true) {
+        {
+            Guard G(self->lock);
+            while(self->queue.empty() && self->running) {
+                UnGuard U(G);
+                self->wakeup.wait();
+            }
+            if(self->queue.empty())
+                break; // stopped
+            batch.swap(self->queue);
+        }
+        {
+            PyLock L;
+            for(size_t i=0; i<batch.size(); i++)
+                call(*batch[i]);
+            // release references with GIL
+            batch.clear();
+        }
+    }
+
+    self->exited.signal();
+}
+
+bool Dispatcher::push(size_t key, const Work::shared_pointer& work)
+{
+    Worker::shared_pointer W;
+    {
+        Guard G(lock);
+        if(!running)
+            return false;
+
+        if(workers.empty()) {
+            for(size_t i=0; i<nworkers; i++) {
+                Worker::shared_pointer N(new Worker);
+                Worker::shared_pointer *arg = new Worker::shared_pointer(N);
+                N->id = epicsThreadCreate("p4p dispatch",
+                                          epicsThreadPriorityMedium,
+                                          epicsThreadGetStackSize(epicsThreadStackBig),
+                                          &Worker::run, arg);
+                if(!N->id) {
+                    delete arg;
+                    break;
+                }
+                workers.push_back(N);
+            }
+            if(workers.empty()) {
+                std::cerr<<"Failed to start p4p dispatch thread\n";
+                return false;
+            }
+        }
+
+        // pointers to Channels are aligned
+        size_t idx = ordered && key ? (key>>4) ^ (key>>12) : next++;
+        W = workers[idx%workers.size()];
+    }
+    return W->push(work);
+}
+
+void Dispatcher::stop(bool wait)
+{
+    std::vector<Worker::shared_pointer> trash;
+    {
+        Guard G(lock);
+        running = false;
+        trash.swap(workers);
+    }
+
+    for(size_t i=0; i<trash.size(); i++) {
+        {
+            Guard G(trash[i]->lock);
+            trash[i]->running = false;
+        }
+        trash[i]->wakeup.signal();
+    }
+
+    if(!wait)
+        return;
+
+    epicsThreadId self(epicsThreadGetIdSelf());
+    for(size_t i=0; i<trash.size(); i++) {
+        // a worker stopping its own Dispatcher exits when it returns
+        if(trash[i]->id!=self)
+            trash[i]->exited.wait();
+    }
+}
+
+bool Dispatcher::isWorker()
+{
+    epicsThreadId self(epicsThreadGetIdSelf());
+    Guard G(lock);
+    for(size_t i=0; i<workers.size(); i++) {
+        if(workers[i]->id==self)
+            return true;
+    }
+    return false;
+}
+
+void Dispatcher::call(Work& work)
+{
+    try {
+        work.run();
+    } catch(std::exception& e) {
+        if(PyErr_Occurred()) {
+            PyErr_Print();
+            PyErr_Clear();
+        } else {
+            std::cerr<<"Error in callback: "<<e.what()<<"\n";
+        }
+    }
+}
+
+// call a python function from a worker
+struct CallWork : public Dispatcher::Work {
+    PyRef fn;
+    explicit CallWork(PyObject *fn) :fn(fn, borrow()) {}
+    virtual ~CallWork() {}
+    virtual void run() {
+        PyRef junk(PyObject_CallFunctionObjArgs(fn.get(), NULL), allownull());
+        if(!junk.get()) {
+            PyErr_Print();
+            PyErr_Clear();
+        }
+    }
+};
+
+// the worker has run all work queued before
+struct SyncWork : public Dispatcher::Work {
+    POINTER_DEFINITIONS(SyncWork);
+    epicsEvent done;
+    virtual ~SyncWork() {}
+    virtual void run() { done.signal(); }
+};
+
+#undef TRY
+#define TRY PyDispatcher::reference_type SELF = PyDispatcher::unwrap(self); try
+
+int Dispatcher::py_init(PyObject *self, PyObject *args, PyObject *kws)
+{
+    TRY {
+        static const char *names[] = {"workers", "ordered", NULL};
+        Py_ssize_t nworkers = 1;
+        PyObject *ordered = Py_True;
+        if(!PyArg_ParseTupleAndKeywords(args, kws, "|nO", (char**)names, &nworkers, &ordered))
+            return -1;
+
+        if(nworkers<=0) {
+            PyErr_SetString(PyExc_ValueError, "workers must be positive");
+            return -1;
+        }
+
+        if(!SELF)
+            SELF.reset(new Dispatcher);
+
+        Guard G(SELF->lock);
+        SELF->nworkers = nworkers;
+        SELF->ordered = PyObject_IsTrue(ordered);
+
+        return 0;
+    }CATCH()
+    return -1;
+}
+
+PyObject *Dispatcher::py_push(PyObject *self, PyObject *args, PyObject *kws)
+{
+    TRY {
+        static const char *names[] = {"callable", "channel", NULL};
+        PyObject *fn, *chan = Py_None;
+        if(!PyArg_ParseTupleAndKeywords(args, kws, "O|O", (char**)names, &fn, &chan))
+            return NULL;
+
+        if(!PyCallable_Check(fn))
+            return PyErr_Format(PyExc_ValueError, "callable required, not %s", Py_TYPE(fn)->tp_name);
+
+        size_t key = 0;
+        if(chan!=Py_None) {
+            if(!PyObject_TypeCheck(chan, &PyChannel::type))
+                return PyErr_Format(PyExc_TypeError, "channel must be a Channel or None, not %s", Py_TYPE(chan)->tp_name);
+            key = size_t(PyChannel::unwrap(chan).get());
+        }
+
+        Work::shared_pointer W(new CallWork(fn));
+        if(!SELF || !SELF->push(key, W))
+            return PyErr_Format(PyExc_RuntimeError, "Dispatcher closed");
+
+        Py_RETURN_NONE;
+    }CATCH()
+    return NULL;
+}
+
+PyObject *Dispatcher::py_sync(PyObject *self)
+{
+    TRY {
+        // a worker would wait for itself
+        if(!SELF || SELF->isWorker())
+            Py_RETURN_NONE;
+
+        std::vector<Worker::shared_pointer> W;
+        {
+            Guard G(SELF->lock);
+            W = SELF->workers;
+        }
+
+        std::vector<SyncWork::shared_pointer> marks;
+        for(size_t i=0; i<W.size(); i++) {
+            SyncWork::shared_pointer M(new SyncWork);
+            if(W[i]->push(M))
+                marks.push_back(M);
+        }
+
+        {
+            PyUnlock U;
+            for(size_t i=0; i<marks.size(); i++)
+                marks[i]->done.wait();
+        }
+
+        Py_RETURN_NONE;
+    }CATCH()
+    return NULL;
+}
+
+PyObject *Dispatcher::py_close(PyObject *self)
+{
+    TRY {
+        if(SELF) {
+            PyUnlock U;
+            SELF->stop();
+        }
+        Py_RETURN_NONE;
+    }CATCH()
+    return NULL;
+}
+
+PyObject *Dispatcher::py_stats(PyObject *self)
+{
+    TRY {
+        size_t nworkers = 0, maxdepth = 0;
+        if(SELF) {
+            Guard G(SELF->lock);
+            nworkers = SELF->workers.size();
+            for(size_t i=0; i<nworkers; i++) {
+                Worker& W = *SELF->workers[i];
+                Guard G2(W.lock);
+                if(maxdepth < W.maxdepth)
+                    maxdepth = W.maxdepth;
+            }
+        }
+        return Py_BuildValue("{snsn}",
+                             "workers", Py_ssize_t(nworkers),
+                             "maxdepth", Py_ssize_t(maxdepth));
+    }CATCH()
+    return NULL;
+}
+
+void GetOp::restart(const Channel::Op::shared_pointer& self)
+{
+    TRACE("channel="<<channel.get()<<" refs="<<self.use_count());
+    if(!channel) return;
+    pva::ChannelGet::shared_pointer temp;
+    GetOp::Req::shared_pointer pyreq(new GetOp::Req(std::tr1::static_pointer_cast<GetOp>(self)));
+    temp.swap(op);
+    {
+        PyUnlock U;
+        if(temp)
+            temp->destroy();
+
+        temp = channel->channel->createChannelGet(pyreq, req);
+        TRACE("start get "<<temp<<" refs="<<self.use_count()<<" req="<<req);
+    }
+    op = temp;
+    channel->track(self);
+}
+
+void GetOp::lostConn(const Channel::Op::shared_pointer &self)
+{
+    if(channel)
+        channel->track(self);
+    if(op) {
+        pva::ChannelGet::shared_pointer temp;
+        temp.swap(op);
+
+        PyUnlock U;
+
+        temp->destroy();
+        temp.reset();
+    }
+}
+
+bool GetOp::cancel()
+{
+    bool canceled = OpBase::cancel();
+
+    if(op) {
+        canceled = true;
+        pva::ChannelGet::shared_pointer temp;
+        temp.swap(op);
+
+        PyUnlock U;
+
+        TRACE("destroy ChannelGet");
+        temp->destroy();
+
+        if(!temp.unique()) {
+            TRACE("remaining refs="<<temp.use_count());
+        }
+
+        temp.reset();
+    }
+
+    return canceled;
+}
+
+void GetOp::Req::channelGetConnect(
+    const pvd::Status& status,
+    pva::ChannelGet::shared_pointer const & channelGet,
+    pvd::Structure::const_shared_pointer const & structure)
+{
+    GetOp::shared_pointer op(owner.lock());
+    if(!op)
+        return;
+
+    TRACE("get start "<<channelGet->getChannel()->getChannelName()<<" "<<status);
+    if(!status.isSuccess()) {
+        OpBase::complete(op, status);
+    } else {
+        channelGet->lastRequest();
+        // may call getDone() recursively
+        channelGet->get();
+    }
+}
+
+void GetOp::Req::getDone(
+    const pvd::Status& status,
+    pva::ChannelGet::shared_pointer const & channelGet,
+    pvd::PVStructure::shared_pointer const & pvStructure,
+    pvd::BitSet::shared_pointer const & bitSet)
+{
+    GetOp::shared_pointer op(owner.lock());
+    if(!op)
+        return;
+
+    TRACE("get complete "<<channelGet->getChannel()->getChannelName()<<" with "<<status);
+    OpBase::complete(op, status, pvStructure);
+}
+
+void PutOp::restart(const Channel::Op::shared_pointer& self)
+{
+    TRACE("channel="<<channel.get()<<" sent="<<sent);
+    if(!channel || sent) return;
+    pva::ChannelPut::shared_pointer temp;
+    PutOp::Req::shared_pointer pyreq(new PutOp::Req(std::tr1::static_pointer_cast<PutOp>(self)));
+    temp.swap(op);
+    {
+        PyUnlock U;
+        if(temp)
+            temp->destroy();
+
+        temp = channel->channel->createChannelPut(pyreq, req);
+        TRACE("start put "<<temp);
+    }
+    op = temp;
+    channel->track(self);
+}
+
+void PutOp::lostConn(const Channel::Op::shared_pointer &self)
+{
+    if(!channel) return;
+    if(op) {
+        pva::ChannelPut::shared_pointer temp;
+        temp.swap(op);
+
+        PyUnlock U;
+
+        temp->destroy();
+        temp.reset();
+    }
+    if(sent) {
+        PyRef err(PyObject_CallFunction(PyExc_RuntimeError, "s", "Connection lost before put acknowledged"));
+        call_cb(err.get());
+    } else {
+        channel->track(self);
+    }
+}
+
+bool PutOp::cancel()
+{
+    bool canceled = OpBase::cancel();
+    sent=true;
+
+    if(op) {
+        canceled = true;
+        pva::ChannelPut::shared_pointer temp;
+        temp.swap(op);
+
+        PyUnlock U;
+
+        temp->destroy();
+        temp.reset();
+    }
+
+    return canceled;
+}
+
+struct PutConnected : public Dispatcher::Work {
+    PutOp::shared_pointer op;
+    pva::ChannelPut::shared_pointer channelPut;
+    pvd::Structure::const_shared_pointer structure;
+    PutConnected(const PutOp::shared_pointer& op, pva::ChannelPut::shared_pointer const & channelPut,
+                 pvd::Structure::const_shared_pointer const & structure)
+        :op(op), channelPut(channelPut), structure(structure) {}
+    virtual ~PutConnected() {}
+    virtual void run() { op->connected(channelPut, structure); }
+};
+
+void PutOp::Req::channelPutConnect(
+    const pvd::Status& status,
+    pva::ChannelPut::shared_pointer const & channelPut,
+    pvd::Structure::const_shared_pointer const & structure)
+{
+    PutOp::shared_pointer op(owner.lock());
+    if(!op)
+        return;
+
+    TRACE("put start "<<channelPut->getChannel()->getChannelName()<<" "<<status);
+
+    if(!status.isSuccess()) {
+        OpBase::complete(op, status);
+    } else {
+        // the value builder is user code
+        op->defer(Dispatcher::Work::shared_pointer(new PutConnected(op, channelPut, structure)));
+    }
+}
+
+void PutOp::connected(pva::ChannelPut::shared_pointer const & channelPut,
+                      pvd::Structure::const_shared_pointer const & structure)
+{
+    if(!channel || sent)
+        return; // cancelled
+
+    pvd::PVStructure::shared_pointer val;
+    pvd::BitSet::shared_pointer mask;
+    try {
+        PyRef temp;
+        temp.swap(pyvalue);
+        if(!temp.get()) {
+            TRACE("no value!?!?!");
+            return;
+        }
+        if(!PyObject_IsInstance(temp.get(), (PyObject*)P4PValue_type)) {
+            // assume callable
+            PyRef ptype(P4PType_wrap(P4PType_type, structure));
+            PyRef val(PyObject_CallFunctionObjArgs(temp.get(), ptype.get(), NULL));
+            temp.swap(val);
+        }
+        if(!PyObject_IsInstance(temp.get(), (PyObject*)P4PValue_type)) {
+            std::ostringstream msg;
+            msg<<"Can't put type \""<<Py_TYPE(temp.get())->tp_name<<"\", only Value";
+            PyRef err(PyObject_CallFunction(PyExc_ValueError, "s", msg.str().c_str()));
+            call_cb(err.get());
+            return;
+        }
+        val = P4PValue_unwrap(temp.get());
+        if(val->getStructure()!=structure) {
+            if(!channel)
+                return; // cancelled
+            // copy by field name into the type of the PV.
+            // send only those fields.
+            pvd::PVStructure::shared_pointer conv(pvd::getPVDataCreate()->createPVStructure(structure));
+            mask.reset(new pvd::BitSet);
+            channel->plan(val->getStructure(), structure)->apply(val, 0, conv, *mask);
+            val = conv;
+        }
+    }catch(std::exception& e) {
+        // complete with the exception raised by the value builder
+        PyRef err;
+        if(PyErr_Occurred()) {
+            PyObject *T, *V, *TB;
+            PyErr_Fetch(&T, &V, &TB);
+            PyErr_NormalizeException(&T, &V, &TB);
+            Py_XDECREF(T);
+            Py_XDECREF(TB);
+            err.reset(V, allownull());
+        }
+        if(!err.get())
+            err.reset(PyObject_CallFunction(PyExc_RuntimeError, "s", e.what()), allownull());
+        if(err.get()) {
+            call_cb(err.get());
+        } else {
+            PyErr_Print();
+            PyErr_Clear();
+            std::cerr<<"Error in channelPutConnect value builder: "<<e.what()<<"\n";
+        }
+        return;
+    }
+    assert(!!val);
+    if(!mask) {
+        mask.reset(new pvd::BitSet(1));
+        mask->set(0);
+    }
+    // no going back now...
+    sent = true;
+
+    PyUnlock U;
+    TRACE("send "<<channelPut->getChannel()->getChannelName()<<" mask="<<*mask<<" value="<<val);
+    channelPut->lastRequest();
+    // may call putDone() recursively
+    channelPut->put(val, mask);
+}
+
+void PutOp::Req::putDone(
+    const pvd::Status& status,
+    pva::ChannelPut::shared_pointer const & channelPut)
+{
+    PutOp::shared_pointer op(owner.lock());
+    if(!op)
+        return;
+
+    TRACE("status="<<status);
+    OpBase::complete(op, status);
+}
+
+void RPCOp::restart(const Channel::Op::shared_pointer& self)
+{
+    TRACE("channel="<<channel.get()<<" sent="<<sent);
+    if(!channel || sent) return;
+    pva::ChannelRPC::shared_pointer temp;
+    RPCOp::Req::shared_pointer pyreq(new RPCOp::Req(std::tr1::static_pointer_cast<RPCOp>(self)));
+    temp.swap(op);
+    {
+        PyUnlock U;
+        if(temp)
+            temp->destroy();
+
+        temp = channel->channel->createChannelRPC(pyreq, req);
+        TRACE("start RPC "<<temp);
+    }
+    op = temp;
+    channel->track(self);
+}
+
+void RPCOp::lostConn(const Channel::Op::shared_pointer &self)
+{
+    if(!channel) return;
+    channel->track(self);
+    if(op) {
+        pva::ChannelRPC::shared_pointer temp;
+        temp.swap(op);
+
+        PyUnlock U;
+
+        temp->destroy();
+        temp.reset();
+    }
+    if(sent) {
+        PyRef err(PyObject_CallFunction(PyExc_RuntimeError, "s", "Connection lost before put acknowledged"));
+        call_cb(err.get());
+    }
+}
+
+bool RPCOp::cancel()
+{
+    bool canceled = OpBase::cancel();
+    sent=true;
+
+    if(op) {
+        canceled = true;
+        pva::ChannelRPC::shared_pointer temp;
+        temp.swap(op);
+
+        PyUnlock U;
+
+        temp->destroy();
+        temp.reset();
+    }
+
+    return canceled;
+}
+
+void RPCOp::Req::channelRPCConnect(
+    const pvd::Status& status,
+    pva::ChannelRPC::shared_pointer const & channelRPC)
+{
+    RPCOp::shared_pointer op(owner.lock());
+    if(!op)
+        return;
+
+    TRACE("rpc start "<<channelRPC->getChannel()->getChannelName()<<" "<<status);
+
+    if(!status.isSuccess()) {
+        OpBase::complete(op, status);
     } else {
-        // build Exception instance
-        // TODO: create RemoteError type
-        V.reset(PyObject_CallFunction(PyExc_RuntimeError, (char*)"s", status.getMessage().c_str()));
+        pvd::PVStructure::shared_pointer val;
+        {
+            PyLock L;
+            op->pvvalue.swap(val);
+        }
+
+        if(val) {
+            channelRPC->lastRequest();
+            channelRPC->request(val);
+        }
     }
+}
 
-    if(!V.get()) {
+void RPCOp::Req::requestDone(
+    const pvd::Status& status,
+    pva::ChannelRPC::shared_pointer const & channelRPC,
+    pvd::PVStructure::shared_pointer const & pvResponse)
+{
+    RPCOp::shared_pointer op(owner.lock());
+    if(!op)
+        return;
+
+    TRACE("rpc done "<<channelRPC->getChannel()->getChannelName()<<" "<<status);
+
+    OpBase::complete(op, status, pvResponse);
+}
+
+void TypeOp::restart(const Channel::Op::shared_pointer& self)
+{
+    if(!channel) return;
+    pvd::StructureConstPtr cached;
+    {
+        Guard G(channel->lock);
+        cached = channel->fieldType;
+        gen = channel->connGen;
+        if(!cached)
+            channel->ops.insert(self);
+    }
+    if(cached) {
+        // complete from cache
+        PyRef T(P4PType_wrap(P4PType_type, cached));
+        Channel::Op::cancel();
+        call_cb(T.get());
+        return;
+    }
+    Req::shared_pointer pyreq(new Req(std::tr1::static_pointer_cast<TypeOp>(self)));
+    pva::Channel::shared_pointer chan(channel->channel);
+
+    PyUnlock U;
+    // may call getDone() recursively
+    chan->getField(pyreq, "");
+}
+
+void TypeOp::lostConn(const Channel::Op::shared_pointer &self)
+{
+    // re-send after reconnect
+    if(channel)
+        channel->track(self);
+}
+
+struct TypeDone : public Dispatcher::Work {
+    TypeOp::shared_pointer op;
+    pvd::Status status;
+    pvd::FieldConstPtr field;
+    TypeDone(const TypeOp::shared_pointer& op, const pvd::Status& status, pvd::FieldConstPtr const & field)
+        :op(op), status(status), field(field) {}
+    virtual ~TypeDone() {}
+    virtual void run() { op->done(status, field); }
+};
+
+void TypeOp::Req::getDone(
+    const pvd::Status& status,
+    pvd::FieldConstPtr const & field)
+{
+    TypeOp::shared_pointer op(owner.lock());
+    if(!op)
+        return;
+    op->defer(Dispatcher::Work::shared_pointer(new TypeDone(op, status, field)));
+}
+
+void TypeOp::done(const pvd::Status& status, pvd::FieldConstPtr const & field)
+{
+    Channel::shared_pointer ch(channel);
+    if(!ch)
+        return; // cancelled, or already complete
+    // the Operation may have been collected, leaving only the cache to fill
+    bool report = cb.get();
+
+    unsigned current;
+    {
+        Guard G(ch->lock);
+        current = ch->connGen;
+    }
+
+    PyRef V;
+    if(!status.isSuccess()) {
+        if(gen!=current)
+            return; // re-sent after reconnect
+        if(report)
+            V.reset(PyObject_CallFunction(PyExc_RuntimeError, (char*)"s", status.getMessage().c_str()), allownull());
+
+    } else if(!field || field->getType()!=pvd::structure) {
+        if(report)
+            V.reset(PyObject_CallFunction(PyExc_RuntimeError, (char*)"s", "PV type is not a Structure"), allownull());
+
+    } else {
+        pvd::StructureConstPtr S(std::tr1::static_pointer_cast<const pvd::Structure>(field));
+        {
+            Guard G(ch->lock);
+            if(gen==ch->connGen)
+                ch->fieldType = S;
+        }
+        if(report) {
+            try {
+                V.reset(P4PType_wrap(P4PType_type, S));
+            } catch(std::exception&) {
+                // python error set
+            }
+        }
+    }
+
+    // complete.  no longer re-sent on reconnect
+    Channel::Op::cancel();
+
+    if(!report) {
+        return;
+    } else if(!V.get()) {
         PyErr_Print();
         PyErr_Clear();
+        std::cerr<<"Error in getField\n";
+    } else {
+        call_cb(V.get());
+    }
+}
+
+void GetterOp::restart(const Channel::Op::shared_pointer& self)
+{
+    if(!channel) return;
+    pva::ChannelGet::shared_pointer temp;
+    Req::shared_pointer pyreq(new Req(std::tr1::static_pointer_cast<GetterOp>(self)));
+    temp.swap(op);
+    current = pyreq;
+    ready = failed = inprog = false;
+    {
+        PyUnlock U;
+        if(temp)
+            temp->destroy();
+
+        // channelGetConnect() may be called before this returns
+        temp = channel->channel->createChannelGet(pyreq, req);
+    }
+    if(current!=pyreq) {
+        // cancel()'d or lostConn() while unlocked
+        PyUnlock U;
+        if(temp)
+            temp->destroy();
+        return;
+    }
+    op = temp;
+    channel->track(self);
+}
+
+void GetterOp::lostConn(const Channel::Op::shared_pointer &self)
+{
+    if(channel)
+        channel->track(self);
+    // keep 'cb' to re-issue get() after reconnect
+    current.reset();
+    ready = failed = inprog = false;
+    if(op) {
+        pva::ChannelGet::shared_pointer temp;
+        temp.swap(op);
+
+        PyUnlock U;
+
+        temp->destroy();
+        temp.reset();
+    }
+}
+
+bool GetterOp::cancel()
+{
+    bool canceled = Channel::Op::cancel();
+    cb.reset();
+    current.reset();
+    ready = failed = inprog = false;
+
+    if(op) {
+        canceled = true;
+        pva::ChannelGet::shared_pointer temp;
+        temp.swap(op);
+
+        PyUnlock U;
+
+        temp->destroy();
+        temp.reset();
+    }
+
+    return canceled;
+}
+
+void GetterOp::issue()
+{
+    if(!ready || inprog || !cb.get() || !op)
+        return;
+    inprog = true;
+    pva::ChannelGet::shared_pointer temp(op);
+
+    PyUnlock U;
+    // may call getDone() recursively
+    temp->get();
+}
+
+// Is no sub-structure of 'S' referenced, eg. by a Value of a sub-structure.
+// Unions are never re-used, as copyUnchecked() may write into the selected field in place.
+bool unreferenced(const pvd::PVStructure& S)
+{
+    const pvd::PVFieldPtrArray& flds(S.getPVFields());
+    for(size_t i=0; i<flds.size(); i++) {
+        switch(flds[i]->getField()->getType()) {
+        case pvd::structure:
+            if(!flds[i].unique() || !unreferenced(static_cast<const pvd::PVStructure&>(*flds[i])))
+                return false;
+            break;
+        case pvd::union_:
+            return false;
+        default:
+            // scalars are copied to python.  arrays are copy-on-write.
+            break;
+        }
+    }
+    return true;
+}
+
+pvd::PVStructure::shared_pointer GetterOp::result(const pvd::PVStructure::shared_pointer& V)
+{
+    // the ChannelGet re-uses pvStructure for the next get(), so always copy
+    pvd::PVStructure::shared_pointer ret;
+    if(recycle && last && last.unique() && last->getStructure()==V->getStructure() && unreferenced(*last))
+        ret = last;
+    else
+        ret = pvd::getPVDataCreate()->createPVStructure(V->getStructure());
+    ret->copyUnchecked(*V);
+    if(recycle)
+        last = ret;
+    return ret;
+}
+
+void GetterOp::Req::channelGetConnect(
+    const pvd::Status& status,
+    pva::ChannelGet::shared_pointer const & channelGet,
+    pvd::Structure::const_shared_pointer const & structure)
+{
+    GetterOp::shared_pointer op(owner.lock());
+    if(!op)
+        return;
+    op->defer(Dispatcher::Work::shared_pointer(new Event(shared_from_this(), status, channelGet)));
+}
+
+void GetterOp::Req::getDone(
+    const pvd::Status& status,
+    pva::ChannelGet::shared_pointer const & channelGet,
+    pvd::PVStructure::shared_pointer const & pvStructure,
+    pvd::BitSet::shared_pointer const & bitSet)
+{
+    GetterOp::shared_pointer op(owner.lock());
+    if(!op)
+        return;
+    op->defer(Dispatcher::Work::shared_pointer(new Event(shared_from_this(), status, pvStructure, bitSet)));
+}
+
+void GetterOp::Req::connected(const pvd::Status& status, pva::ChannelGet::shared_pointer const & channelGet)
+{
+    GetterOp::shared_pointer op(owner.lock());
+    if(!op)
+        return;
+    if(op->current.get()!=this)
+        return; // from a previous ChannelGet
+
+    TRACE("getter start "<<channelGet->getChannel()->getChannelName()<<" "<<status);
+    if(!status.isSuccess()) {
+        // otherwise no get() could be sent until a reconnect
+        op->failed = true;
+
+        PyRef temp;
+        op->cb.swap(temp);
+        if(!temp.get())
+            return;
+        PyRef E(PyObject_CallFunction(PyExc_RuntimeError, (char*)"s", status.getMessage().c_str()));
+        PyRef junk(PyObject_CallFunctionObjArgs(temp.get(), E.get(), NULL), allownull());
+        if(!junk.get()) {
+            PyErr_Print();
+            PyErr_Clear();
+        }
     } else {
-        op->call_cb(V.get());
+        op->op = channelGet;
+        op->ready = true;
+        op->issue();
+    }
+}
+
+void GetterOp::Req::done(const pvd::Status& status,
+                          pvd::PVStructure::shared_pointer const & pvStructure,
+                          pvd::BitSet::shared_pointer const & bitSet)
+{
+    GetterOp::shared_pointer op(owner.lock());
+    if(!op)
+        return;
+    if(op->current.get()!=this)
+        return;
+
+    op->inprog = false;
+
+    PyRef temp;
+    op->cb.swap(temp);
+    if(!temp.get())
+        return;
+
+    try {
+        PyRef V;
+        if(status.isSuccess()) {
+            pvd::BitSet::shared_pointer M;
+            if(bitSet) {
+                M.reset(new pvd::BitSet);
+                *M = *bitSet;
+            }
+            V.reset(P4PValue_wrap(P4PValue_type, op->result(pvStructure), M));
+        } else {
+            V.reset(PyObject_CallFunction(PyExc_RuntimeError, (char*)"s", status.getMessage().c_str()));
+        }
+
+        PyRef junk(PyObject_CallFunctionObjArgs(temp.get(), V.get(), NULL));
+    } catch(std::exception& e) {
+        if(PyErr_Occurred()) {
+            PyErr_Print();
+            PyErr_Clear();
+        } else {
+            std::cerr<<"Error in getDone() "<<e.what()<<"\n";
+        }
     }
 }
 
-void PutOp::restart(const Channel::Op::shared_pointer& self)
+#undef TRY
+#define TRY PyGetter::reference_type SELF = PyGetter::unwrap(self); try
+
+PyObject *GetterOp::py_get(PyObject *self, PyObject *args, PyObject *kws)
+{
+    TRY {
+        static const char *names[] = {"callback", NULL};
+        PyObject *cb;
+        if(!PyArg_ParseTupleAndKeywords(args, kws, "O", (char**)names, &cb))
+            return NULL;
+
+        if(!PyCallable_Check(cb))
+            return PyErr_Format(PyExc_ValueError, "callable required, not %s", Py_TYPE(cb)->tp_name);
+
+        if(!SELF->channel)
+            return PyErr_Format(PyExc_RuntimeError, "Getter closed");
+        else if(SELF->cb.get())
+            return PyErr_Format(PyExc_RuntimeError, "get() already in progress");
+
+        SELF->cb.reset(cb, borrow());
+        if(SELF->failed) {
+            // retry the server operation.  Any error is passed to this callback
+            SELF->failed = false;
+            SELF->channel->start(SELF);
+        } else {
+            // otherwise sent once (re)connected
+            SELF->issue();
+        }
+
+        Py_RETURN_NONE;
+    }CATCH()
+    return NULL;
+}
+
+PyObject *GetterOp::py_close(PyObject *self)
+{
+    TRY {
+        if(SELF->channel)
+            SELF->cancel();
+        Py_RETURN_NONE;
+    }CATCH()
+    return NULL;
+}
+
+int GetterOp::py_traverse(PyObject *self, visitproc visit, void *arg)
+{
+    TRY {
+        if(SELF && SELF->cb.get())
+            Py_VISIT(SELF->cb.get());
+        return 0;
+    }CATCH()
+    return -1;
+}
+
+int GetterOp::py_clear(PyObject *self)
 {
-    TRACE("channel="<<channel.get()<<" sent="<<sent);
-    if(!channel || sent) return;
+    TRY {
+        // also called on dealloc.  Nothing else will use the ChannelGet
+        if(SELF && SELF->channel)
+            SELF->cancel();
+        PyRef tmp;
+        if(SELF)
+            SELF->cb.swap(tmp);
+        return 0;
+    }CATCH()
+    return -1;
+}
+
+void PutterOp::restart(const Channel::Op::shared_pointer& self)
+{
+    if(!channel) return;
     pva::ChannelPut::shared_pointer temp;
-    PutOp::Req::shared_pointer pyreq(new PutOp::Req(std::tr1::static_pointer_cast<PutOp>(self)));
+    Req::shared_pointer pyreq(new Req(std::tr1::static_pointer_cast<PutterOp>(self)));
     temp.swap(op);
+    current = pyreq;
+    ready = inprog = false;
     {
         PyUnlock U;
         if(temp)
             temp->destroy();
 
+        // channelPutConnect() may be called before this returns
         temp = channel->channel->createChannelPut(pyreq, req);
-        TRACE("start put "<<temp);
+    }
+    if(current!=pyreq) {
+        // cancel()'d or lostConn() while unlocked
+        PyUnlock U;
+        if(temp)
+            temp->destroy();
+        return;
     }
     op = temp;
-    channel->ops.insert(self);
+    channel->track(self);
 }
 
-void PutOp::lostConn(const Channel::Op::shared_pointer &self)
+void PutterOp::lostConn(const Channel::Op::shared_pointer &self)
 {
-    if(!channel) return;
+    if(channel)
+        channel->track(self);
+    current.reset();
+    ready = false;
     if(op) {
         pva::ChannelPut::shared_pointer temp;
         temp.swap(op);
@@ -1211,18 +4350,23 @@ void PutOp::lostConn(const Channel::Op::shared_pointer &self)
         temp->destroy();
         temp.reset();
     }
-    if(sent) {
+    if(inprog) {
+        // may have been applied.  Can't safely re-send.
+        inprog = false;
         PyRef err(PyObject_CallFunction(PyExc_RuntimeError, "s", "Connection lost before put acknowledged"));
-        call_cb(err.get());
-    } else {
-        channel->ops.insert(self);
+        complete(err.get());
     }
+    // a put() not yet sent is sent after reconnect
 }
 
-bool PutOp::cancel()
+bool PutterOp::cancel()
 {
-    bool canceled = OpBase::cancel();
-    sent=true;
+    bool canceled = Channel::Op::cancel();
+    cb.reset();
+    value.reset();
+    mask.reset();
+    current.reset();
+    ready = inprog = false;
 
     if(op) {
         canceled = true;
@@ -1238,91 +4382,113 @@ bool PutOp::cancel()
     return canceled;
 }
 
-void PutOp::Req::channelPutConnect(
+void PutterOp::complete(PyObject *obj)
+{
+    value.reset();
+    mask.reset();
+    PyRef temp;
+    cb.swap(temp);
+    if(!temp.get())
+        return;
+    PyObject *junk = PyObject_CallFunctionObjArgs(temp.get(), obj, NULL);
+    if(junk) {
+        Py_DECREF(junk);
+    } else {
+        PyErr_Print();
+        PyErr_Clear();
+    }
+}
+
+void PutterOp::issue()
+{
+    if(!ready || inprog || !value || !op || !channel)
+        return;
+
+    pvd::PVStructure::shared_pointer val(value);
+    pvd::BitSet::shared_pointer M(mask);
+
+    if(val->getStructure()!=type) {
+        // copy marked fields by name into the type of the PV
+        try {
+            pvd::PVStructure::shared_pointer conv(pvd::getPVDataCreate()->createPVStructure(type));
+            pvd::BitSet::shared_pointer cmask(new pvd::BitSet);
+            channel->plan(val->getStructure(), type)->apply(val, M.get(), conv, *cmask);
+            val = conv;
+            M = cmask;
+        } catch(std::exception& e) {
+            PyRef err(PyObject_CallFunction(PyExc_ValueError, "s", e.what()));
+            complete(err.get());
+            return;
+        }
+    }
+
+    inprog = true;
+    pva::ChannelPut::shared_pointer temp(op);
+
+    PyUnlock U;
+    TRACE("send "<<temp->getChannel()->getChannelName()<<" mask="<<*M);
+    // may call putDone() recursively
+    temp->put(val, M);
+}
+
+void PutterOp::Req::channelPutConnect(
     const pvd::Status& status,
     pva::ChannelPut::shared_pointer const & channelPut,
     pvd::Structure::const_shared_pointer const & structure)
 {
-    PutOp::shared_pointer op(owner.lock());
+    PutterOp::shared_pointer op(owner.lock());
     if(!op)
         return;
+    op->defer(Dispatcher::Work::shared_pointer(new Event(shared_from_this(), status, channelPut, structure)));
+}
 
-    TRACE("put start "<<channelPut->getChannel()->getChannelName()<<" "<<status);
+void PutterOp::Req::putDone(
+    const pvd::Status& status,
+    pva::ChannelPut::shared_pointer const & channelPut)
+{
+    PutterOp::shared_pointer op(owner.lock());
+    if(!op)
+        return;
+    op->defer(Dispatcher::Work::shared_pointer(new Event(shared_from_this(), status)));
+}
+
+void PutterOp::Req::connected(const pvd::Status& status,
+                              pva::ChannelPut::shared_pointer const & channelPut,
+                              pvd::Structure::const_shared_pointer const & structure)
+{
+    PutterOp::shared_pointer op(owner.lock());
+    if(!op)
+        return;
+    if(op->current.get()!=this)
+        return; // from a previous ChannelPut
 
+    TRACE("putter start "<<channelPut->getChannel()->getChannelName()<<" "<<status);
     if(!status.isSuccess()) {
-        PyLock L;
         PyRef err(PyObject_CallFunction(PyExc_RuntimeError, "s", status.getMessage().c_str()));
-        op->call_cb(err.get());
+        op->complete(err.get());
     } else {
-        pvd::PVStructure::shared_pointer val;
-        {
-            PyLock L;
-            try {
-                PyRef temp;
-                temp.swap(op->pyvalue);
-                if(!temp.get()) {
-                    TRACE("no value!?!?!");
-                    return;
-                }
-                //TODO: bitset?
-                if(!PyObject_IsInstance(temp.get(), (PyObject*)P4PValue_type)) {
-                    // assume callable
-                    PyRef ptype(P4PType_wrap(P4PType_type, structure));
-                    PyRef val(PyObject_CallFunctionObjArgs(temp.get(), ptype.get(), NULL));
-                    temp.swap(val);
-                }
-                if(!PyObject_IsInstance(temp.get(), (PyObject*)P4PValue_type)) {
-                    std::ostringstream msg;
-                    msg<<"Can't put type \""<<Py_TYPE(temp.get())->tp_name<<"\", only Value";
-                    PyRef err(PyObject_CallFunction(PyExc_ValueError, "s", msg.str().c_str()));
-                    op->call_cb(err.get());
-                    return;
-                }
-                val = P4PValue_unwrap(temp.get());
-                if(val->getStructure()!=structure) {
-                    //TODO: attempt safe copy
-                    PyRef err(PyObject_CallFunction(PyExc_NotImplementedError, "s", "channelPutConnect() safe copy unimplemneted"));
-                    op->call_cb(err.get());
-                    return;
-                }
-            }catch(std::exception& e) {
-                PyErr_Print();
-                PyErr_Clear();
-                std::cerr<<"Error in channelPutConnect value builder: "<<e.what()<<"\n";
-                return;
-            }
-        }
-        assert(!!val);
-        pvd::BitSet::shared_pointer mask(new pvd::BitSet(1));
-        mask->set(0);
-        TRACE("send "<<channelPut->getChannel()->getChannelName()<<" mask="<<*mask<<" value="<<val);
-        channelPut->lastRequest();
-        // may call putDone() recursively
-        channelPut->put(val, mask);
-        // no going back now...
-        op->sent = true;
+        op->op = channelPut;
+        op->type = structure;
+        op->ready = true;
+        op->issue();
     }
 }
 
-void PutOp::Req::putDone(
-    const pvd::Status& status,
-    pva::ChannelPut::shared_pointer const & channelPut)
+void PutterOp::Req::done(const pvd::Status& status)
 {
-    PutOp::shared_pointer op(owner.lock());
+    PutterOp::shared_pointer op(owner.lock());
     if(!op)
         return;
+    if(op->current.get()!=this)
+        return;
 
-    PyLock L;
-    TRACE("status="<<status);
-    if(!op->cb.get()) return;
-    PyRef V;
+    op->inprog = false;
 
+    PyRef V;
     if(status.isSuccess()) {
         V.reset(Py_None, borrow());
     } else {
-        // build Exception instance
-        // TODO: create RemoteError type
-        V.reset(PyObject_CallFunction(PyExc_RuntimeError, (char*)"s", status.getMessage().c_str()));
+        V.reset(PyObject_CallFunction(PyExc_RuntimeError, (char*)"s", status.getMessage().c_str()), allownull());
     }
 
     if(!V.get()) {
@@ -1330,122 +4496,134 @@ void PutOp::Req::putDone(
         PyErr_Clear();
         std::cerr<<"Error in putDone\n";
     } else {
-        op->call_cb(V.get());
+        op->complete(V.get());
     }
 }
 
-void RPCOp::restart(const Channel::Op::shared_pointer& self)
+#undef TRY
+#define TRY PyPutter::reference_type SELF = PyPutter::unwrap(self); try
+
+PyObject *PutterOp::py_put(PyObject *self, PyObject *args, PyObject *kws)
 {
-    TRACE("channel="<<channel.get()<<" sent="<<sent);
-    if(!channel || sent) return;
-    pva::ChannelRPC::shared_pointer temp;
-    RPCOp::Req::shared_pointer pyreq(new RPCOp::Req(std::tr1::static_pointer_cast<RPCOp>(self)));
-    temp.swap(op);
-    {
-        PyUnlock U;
-        if(temp)
-            temp->destroy();
+    TRY {
+        static const char *names[] = {"callback", "value", NULL};
+        PyObject *cb, *val;
+        if(!PyArg_ParseTupleAndKeywords(args, kws, "OO!", (char**)names, &cb, P4PValue_type, &val))
+            return NULL;
 
-        temp = channel->channel->createChannelRPC(pyreq, req);
-        TRACE("start RPC "<<temp);
-    }
-    op = temp;
-    channel->ops.insert(self);
-}
+        if(!PyCallable_Check(cb))
+            return PyErr_Format(PyExc_ValueError, "callable required, not %s", Py_TYPE(cb)->tp_name);
 
-void RPCOp::lostConn(const Channel::Op::shared_pointer &self)
-{
-    if(!channel) return;
-    channel->ops.insert(self);
-    if(op) {
-        pva::ChannelRPC::shared_pointer temp;
-        temp.swap(op);
+        if(!SELF->channel)
+            return PyErr_Format(PyExc_RuntimeError, "Putter closed");
+        else if(SELF->cb.get())
+            return PyErr_Format(PyExc_RuntimeError, "put() already in progress");
+
+        // send only changed fields.  Everything if nothing is marked.
+        pvd::BitSet::shared_pointer I(P4PValue_unwrap_bitset(val));
+        pvd::BitSet::shared_pointer M(new pvd::BitSet);
+        if(I && !I->isEmpty())
+            *M = *I;
+        else
+            M->set(0);
 
-        PyUnlock U;
+        SELF->value = P4PValue_unwrap(val);
+        SELF->mask = M;
+        SELF->cb.reset(cb, borrow());
+        // otherwise sent once (re)connected
+        SELF->issue();
 
-        temp->destroy();
-        temp.reset();
-    }
-    if(sent) {
-        PyRef err(PyObject_CallFunction(PyExc_RuntimeError, "s", "Connection lost before put acknowledged"));
-        call_cb(err.get());
-    }
+        Py_RETURN_NONE;
+    }CATCH()
+    return NULL;
 }
 
-bool RPCOp::cancel()
+PyObject *PutterOp::py_type(PyObject *self)
 {
-    bool canceled = OpBase::cancel();
-    sent=true;
-
-    if(op) {
-        canceled = true;
-        pva::ChannelRPC::shared_pointer temp;
-        temp.swap(op);
-
-        PyUnlock U;
-
-        temp->destroy();
-        temp.reset();
-    }
-
-    return canceled;
+    TRY {
+        if(!SELF || !SELF->type)
+            Py_RETURN_NONE;
+        return P4PType_wrap(P4PType_type, SELF->type);
+    }CATCH()
+    return NULL;
 }
 
-void RPCOp::Req::channelRPCConnect(
-    const pvd::Status& status,
-    pva::ChannelRPC::shared_pointer const & channelRPC)
+PyObject *PutterOp::py_value(PyObject *self)
 {
-    RPCOp::shared_pointer op(owner.lock());
-    if(!op)
-        return;
-
-    TRACE("rpc start "<<channelRPC->getChannel()->getChannelName()<<" "<<status);
-
-    if(!status.isSuccess()) {
-        PyLock L;
-        PyRef err(PyObject_CallFunction(PyExc_RuntimeError, "s", status.getMessage().c_str()));
-        op->call_cb(err.get());
-    } else {
-        pvd::PVStructure::shared_pointer val;
-        {
-            PyLock L;
-            op->pvvalue.swap(val);
-        }
-
-        if(val) {
-            channelRPC->lastRequest();
-            channelRPC->request(val);
-        }
-    }
+    TRY {
+        if(!SELF || !SELF->type)
+            Py_RETURN_NONE;
+        pvd::PVStructure::shared_pointer V(pvd::getPVDataCreate()->createPVStructure(SELF->type));
+        pvd::BitSet::shared_pointer I(new pvd::BitSet(V->getNextFieldOffset()));
+        return P4PValue_wrap(P4PValue_type, V, I);
+    }CATCH()
+    return NULL;
 }
 
-void RPCOp::Req::requestDone(
-    const pvd::Status& status,
-    pva::ChannelRPC::shared_pointer const & channelRPC,
-    pvd::PVStructure::shared_pointer const & pvResponse)
+PyObject *PutterOp::py_close(PyObject *self)
 {
-    RPCOp::shared_pointer op(owner.lock());
-    if(!op)
-        return;
-
-    TRACE("rpc done "<<channelRPC->getChannel()->getChannelName()<<" "<<status);
+    TRY {
+        if(SELF->channel)
+            SELF->cancel();
+        Py_RETURN_NONE;
+    }CATCH()
+    return NULL;
+}
 
-    PyLock L;
+int PutterOp::py_traverse(PyObject *self, visitproc visit, void *arg)
+{
+    TRY {
+        if(SELF && SELF->cb.get())
+            Py_VISIT(SELF->cb.get());
+        return 0;
+    }CATCH()
+    return -1;
+}
 
-    if(!status.isSuccess()) {
-        PyRef err(PyObject_CallFunction(PyExc_RuntimeError, "s", status.getMessage().c_str()));
-        op->call_cb(err.get());
-    } else {
-        PyRef val(P4PValue_wrap(P4PValue_type, pvResponse));
-        op->call_cb(val.get());
-    }
+int PutterOp::py_clear(PyObject *self)
+{
+    TRY {
+        // also called on dealloc.  Nothing else will use the ChannelPut
+        if(SELF && SELF->channel)
+            SELF->cancel();
+        PyRef tmp;
+        if(SELF)
+            SELF->cb.swap(tmp);
+        return 0;
+    }CATCH()
+    return -1;
 }
 
 static PyMethodDef Context_methods[] = {
     {"channel", (PyCFunction)&Context::py_channel, METH_VARARGS|METH_KEYWORDS,
-     "Return a Channel"},
+     "channel(name, priority=0) -> Channel\n\n"
+     "Return a Channel.  Channels with the same name and priority share one connection,\n"
+     "which is kept for idleTimeout seconds after the last Channel and operation using it is released."},
     {"close", (PyCFunction)&Context::py_close, METH_NOARGS,
-     "Close this Context"},
+     "Close this Context, and all Channels"},
+    {"poolStats", (PyCFunction)&Context::py_poolStats, METH_NOARGS,
+     "poolStats() -> {'channels':0, 'idle':0}\n\n"
+     "Number of Channels cached, and how many of those are unused."},
+    {"get_many", (PyCFunction)&Context::py_get_many, METH_VARARGS|METH_KEYWORDS,
+     "get_many(names, requests=None, timeout=5.0) -> [Value|Exception, ...]\n\n"
+     "Fetch the values of many PVs at once, blocking until all complete, or timeout.\n"
+     "requests may be one request for all, or a list of requests.\n"
+     "Operations not complete after timeout seconds (<0 to wait forever) are\n"
+     "cancelled and reported with TimeoutError."},
+    {"put_many", (PyCFunction)&Context::py_put_many, METH_VARARGS|METH_KEYWORDS,
+     "put_many(names, values, requests=None, timeout=5.0) -> [None|Exception, ...]\n\n"
+     "Write many PVs at once.  Each value is a Value, or a callable which is passed the Type\n"
+     "of the PV and returns a Value.  Otherwise as get_many()."},
+    {"rpc_many", (PyCFunction)&Context::py_rpc_many, METH_VARARGS|METH_KEYWORDS,
+     "rpc_many(names, values, requests=None, timeout=5.0) -> [Value|Exception, ...]\n\n"
+     "Make many RPC calls at once.  Each value is a Value.  Otherwise as get_many()."},
+    {"connect_many", (PyCFunction)&Context::py_connect_many, METH_VARARGS|METH_KEYWORDS,
+     "connect_many(names, timeout=5.0, keep=None) -> (set(connected), set(unconnected))\n\n"
+     "Create Channels for many PVs at once, and wait until all are connected, or timeout (<0 to wait forever).\n"
+     "Returns the names which are connected, and those which are not.\n"
+     "The Channels are kept in the pool for later use by channel() and *_many().\n"
+     "With keep=None they are unused, so closed after idleTimeout, or by the next operation when more than maxIdle.\n"
+     "Otherwise they are kept for at least 'keep' seconds, whatever maxIdle, then treated as unused."},
     {"providers", (PyCFunction)&Context::py_providers, METH_NOARGS|METH_STATIC,
      "providers() -> ['name', ...]\n"
      ":returns: A list of all currently registered provider names.\n\n"
@@ -1474,23 +4652,58 @@ static PyMethodDef Channel_methods[] = {
     {"getName", (PyCFunction)&Channel::py_name, METH_NOARGS,
      "Channel name (aka PV name)"},
     {"get", (PyCFunction)&Channel::py_get, METH_VARARGS|METH_KEYWORDS,
-     "get(callback, request=None)\n\nInitiate a new get() operation.\n"
+     "get(callback, request=None, timeout=0.0)\n\nInitiate a new get() operation.\n"
      "The provided callback must be a callable object, which will be called with a single argument.\n"
-     "Either a Value or an Exception."},
+     "Either a Value or an Exception.\n"
+     "If timeout>0, and the get() has not completed after this many seconds, the operation\n"
+     "is cancelled and callback is called with a TimeoutError."},
     {"put", (PyCFunction)&Channel::py_put, METH_VARARGS|METH_KEYWORDS,
-     "put(callback, value, request=None)\n\nInitiate a new put() operation.\n"
+     "put(callback, value, request=None, timeout=0.0)\n\nInitiate a new put() operation.\n"
      "The provided callback must be a callable object, which will be called with a single argument.\n"
-     "Either None or an Exception."},
+     "Either None or an Exception.  timeout as for get()."},
     {"rpc", (PyCFunction)&Channel::py_rpc, METH_VARARGS|METH_KEYWORDS,
-     "rpc(callback, value, request=None)\n\nInitiate a new rpc() operation.\n"
+     "rpc(callback, value, request=None, timeout=0.0)\n\nInitiate a new rpc() operation.\n"
      "The provided callback must be a callable object, which will be called with a single argument.\n"
-     "Either None or an Exception."},
+     "Either None or an Exception.  timeout as for get()."},
     {"monitor", (PyCFunction)&Channel::py_monitor, METH_VARARGS|METH_KEYWORDS,
-     "monitor(callback, request=None)\n\nInitiate a new rpc() operation.\n"
+     "monitor(callback, request=None, borrow=False, queueSize=None, pipeline=None, ackAny=None, timeout=0.0)\n\nInitiate a new monitor() operation.\n"
      "The provided callback must be a callable object, which will be called with a single argument.\n"
-     "Either None or an Exception."},
+     "Either None or an Exception.\n"
+     "None is passed when updates become available, and not again until pop() has found the queue empty,\n"
+     "or the callback has raised an exception, in which case the next update notifies again.\n"
+     "If borrow=True, Values returned by Subscription.pop() reference the received data without a copy.\n"
+     "Each update is returned to the server queue only when its Value is collected.\n"
+     "queueSize, pipeline, and ackAny are added to the record._options of the request.\n"
+     "With pipeline=True the server sends no more than queueSize updates ahead of\n"
+     "those acknowledged, which are acknowledged as they are pop()'d (or, with borrow=True, collected).\n"
+     "An acknowledgement is sent each time ackAny updates (count or percentage of queueSize) have been consumed.\n"
+     "If timeout>0, and the subscription has not been established after this many seconds,\n"
+     "it is closed and callback is called with a TimeoutError."},
+    {"type", (PyCFunction)&Channel::py_type, METH_VARARGS|METH_KEYWORDS,
+     "type(callback=None) -> Type | Operation\n\n"
+     "Without a callback, return the Type of the PV if known, or None.\n"
+     "With a callback, fetch the Type (once connected) and call callback with the Type or an Exception.\n"
+     "The Type is kept until the connection is lost, and later calls complete\n"
+     "immediately, before type() returns.\n"
+     "The Type is fetched, and kept, even if the returned Operation is collected first."},
+    {"getter", (PyCFunction)&Channel::py_getter, METH_VARARGS|METH_KEYWORDS,
+     "getter(request=None, recycle=False) -> Getter\n\n"
+     "A Getter keeps one get operation open on the server, so that repeated get() calls\n"
+     "each need only one round trip.\n"
+     "With recycle=True, each Value re-uses the storage of the previous Value if it,\n"
+     "and any Value of a sub-structure, has been collected."},
+    {"putter", (PyCFunction)&Channel::py_putter, METH_VARARGS|METH_KEYWORDS,
+     "putter(request=None) -> Putter\n\n"
+     "A Putter keeps one put operation open on the server, so that repeated put() calls\n"
+     "each need only one round trip, and send only changed fields."},
     {"close", (PyCFunction)&Channel::py_close, METH_NOARGS,
-      "close()\n\nDispose of channel."},
+      "close()\n\nRelease this Channel.  Operations already started continue.\n"
+      "The connection is closed when it has been unused for the idleTimeout of the Context."},
+    {"_convert", (PyCFunction)&Channel::py_convert, METH_VARARGS|METH_KEYWORDS,
+     "_convert(value, type, changed=False) -> Value\n\n"
+     "Copy value into a new Value of type, as put() does when the type of the PV differs.\n"
+     "With changed=True only the fields of value marked as changed are copied, as Putter.put().\n"
+     "Fields copied are marked as changed in the result.  For testing."},
     {NULL}
 };
 
@@ -1522,7 +4735,27 @@ static PyMethodDef PyMonitorOp_methods[] = {
     {"done", (PyCFunction)&MonitorOp::py_done, METH_NOARGS,
      "Has the last subscription update been received?  Check after pop() returns None."},
     {"pop", (PyCFunction)&MonitorOp::py_pop, METH_NOARGS,
-     "Pull an entry from the subscription queue.  return None if empty"},
+     "Pull an entry from the subscription queue.  return None if empty,\n"
+     "after which the next update will again call the monitor() callback."},
+    {"pop_many", (PyCFunction)&MonitorOp::py_pop_many, METH_VARARGS|METH_KEYWORDS,
+     "pop_many(max=0) -> [Value, ...]\n\n"
+     "Pull up to 'max' entries from the subscription queue.  max<=0 for all.\n"
+     "Returns an empty list if the queue is empty."},
+    {"pop_columns", (PyCFunction)&MonitorOp::py_pop_columns, METH_VARARGS|METH_KEYWORDS,
+     "pop_columns(fields, max=0, overrun=False) -> {'fld':column, ...}\n\n"
+     "Pull up to 'max' entries from the subscription queue.  max<=0 for all.\n"
+     "Returns only the named scalar fields of each entry.\n"
+     "Numeric fields as numpy arrays, strings as lists.\n"
+     "Raises KeyError, without taking any entry, if a name is not a scalar field.\n"
+     "A batch ends early at an entry of a different type (after a reconnect),\n"
+     "which begins the next batch.\n"
+     "With overrun=True, returns a tuple of the columns and {'fld':overruns, ...}\n"
+     "where each is a numpy bool array.  True where Value.overrun('fld') would be."},
+    {"stats", (PyCFunction)&MonitorOp::py_stats, METH_NOARGS,
+     "stats() -> {'updates':0, 'overruns':0, 'maxdepth':0}\n\n"
+     "Count of updates popped, and of those updates where the server squashed\n"
+     "intermediate changes.  See Value.overrun()\n"
+     "maxdepth is the most updates found queued, ie. popped before the queue was next empty."},
     {NULL}
 };
 
@@ -1533,6 +4766,108 @@ PyTypeObject PyMonitorOp::type = {
     sizeof(PyMonitorOp),
 };
 
+static PyMethodDef Selector_methods[] = {
+    {"fileno", (PyCFunction)&Selector::py_fileno, METH_NOARGS,
+     "fileno() -> int\n\n"
+     "A file descriptor which becomes readable when ready() would return a non-empty list.\n"
+     "For use with select(), poll(), or similar."},
+    {"add", (PyCFunction)&Selector::py_add, METH_VARARGS,
+     "add(Subscription)\n\n"
+     "Notify through this Selector instead of calling the Subscription callback on new updates.\n"
+     "The callback is still called with errors, and when the subscription completes."},
+    {"remove", (PyCFunction)&Selector::py_remove, METH_VARARGS,
+     "remove(Subscription)\n\n"
+     "Undo add()"},
+    {"ready", (PyCFunction)&Selector::py_ready, METH_NOARGS,
+     "ready() -> [Subscription, ...]\n\n"
+     "List of Subscriptions notified since the last call.\n"
+     "pop() from each until empty, or it will not be listed again."},
+    {"close", (PyCFunction)&Selector::py_close, METH_NOARGS,
+     "close()\n\n"
+     "remove() all Subscriptions and close fileno()"},
+    {NULL}
+};
+
+template<>
+PyTypeObject PySelector::type = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "p4p._p4p.Selector",
+    sizeof(PySelector),
+};
+
+static PyMethodDef Getter_methods[] = {
+    {"get", (PyCFunction)&GetterOp::py_get, METH_VARARGS|METH_KEYWORDS,
+     "get(callback)\n\n"
+     "Fetch the current value.  The callback is called with a Value or an Exception.\n"
+     "Only one get() may be in progress at a time.\n"
+     "If the connection is lost, the get() is re-sent once it is re-established.\n"
+     "If the server refused the get operation, it is requested again, and any error passed to the callback."},
+    {"close", (PyCFunction)&GetterOp::py_close, METH_NOARGS,
+     "close()\n\nCancel any get() in progress, and close the server operation."},
+    {NULL}
+};
+
+template<>
+PyTypeObject PyGetter::type = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "p4p._p4p.Getter",
+    sizeof(PyGetter),
+};
+
+static PyMethodDef Putter_methods[] = {
+    {"put", (PyCFunction)&PutterOp::py_put, METH_VARARGS|METH_KEYWORDS,
+     "put(callback, value)\n\n"
+     "Send the fields of value which are marked as changed, or all fields if none are marked.\n"
+     "If value does not have the Type of the PV (see value()), fields are copied by name,\n"
+     "and scalar and array fields converted.\n"
+     "The callback is called with None or an Exception.\n"
+     "Only one put() may be in progress at a time.\n"
+     "A put() not yet sent when the connection is lost is sent once it is re-established."},
+    {"type", (PyCFunction)&PutterOp::py_type, METH_NOARGS,
+     "type() -> Type\n\n"
+     "The Type of the PV, or None if not yet connected."},
+    {"value", (PyCFunction)&PutterOp::py_value, METH_NOARGS,
+     "value() -> Value\n\n"
+     "A new Value of the Type of the PV, with no fields marked as changed.\n"
+     "None if not yet connected."},
+    {"close", (PyCFunction)&PutterOp::py_close, METH_NOARGS,
+     "close()\n\nCancel any put() in progress, and close the server operation."},
+    {NULL}
+};
+
+template<>
+PyTypeObject PyPutter::type = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "p4p._p4p.Putter",
+    sizeof(PyPutter),
+};
+
+static PyMethodDef Dispatcher_methods[] = {
+    {"push", (PyCFunction)&Dispatcher::py_push, METH_VARARGS|METH_KEYWORDS,
+     "push(callable, channel=None)\n\n"
+     "Call callable() from a worker.  If channel is given, after the callbacks\n"
+     "of that Channel already queued (when ordered)."},
+    {"sync", (PyCFunction)&Dispatcher::py_sync, METH_NOARGS,
+     "sync()\n\n"
+     "Wait until all work queued before this call has run.\n"
+     "Returns immediately when called from a worker."},
+    {"close", (PyCFunction)&Dispatcher::py_close, METH_NOARGS,
+     "close()\n\n"
+     "Run any work already queued, then stop all workers.\n"
+     "Later callbacks are made from the PVA thread, as if no Dispatcher were given."},
+    {"stats", (PyCFunction)&Dispatcher::py_stats, METH_NOARGS,
+     "stats() -> {'workers':0, 'maxdepth':0}\n\n"
+     "Number of worker threads started, and the largest number of callbacks queued to one worker."},
+    {NULL}
+};
+
+template<>
+PyTypeObject PyDispatcher::type = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "p4p._p4p.Dispatcher",
+    sizeof(PyDispatcher),
+};
+
 void unfactory()
 {
     pva::ca::CAClientFactory::stop();
@@ -1615,4 +4950,84 @@ void p4p_client_register(PyObject *mod)
         throw std::runtime_error("failed to add p4p._p4p.Subscription");
     }
 
+    PyGetter::buildType();
+    PyGetter::type.tp_flags = Py_TPFLAGS_DEFAULT|Py_TPFLAGS_HAVE_GC;
+    PyGetter::type.tp_traverse = &GetterOp::py_traverse;
+    PyGetter::type.tp_clear = &GetterOp::py_clear;
+
+    PyGetter::type.tp_methods = Getter_methods;
+
+    if(PyType_Ready(&PyGetter::type))
+        throw std::runtime_error("failed to initialize PyGetter");
+
+    Py_INCREF((PyObject*)&PyGetter::type);
+    if(PyModule_AddObject(mod, "Getter", (PyObject*)&PyGetter::type)) {
+        Py_DECREF((PyObject*)&PyGetter::type);
+        throw std::runtime_error("failed to add p4p._p4p.Getter");
+    }
+
+    PyPutter::buildType();
+    PyPutter::type.tp_flags = Py_TPFLAGS_DEFAULT|Py_TPFLAGS_HAVE_GC;
+    PyPutter::type.tp_traverse = &PutterOp::py_traverse;
+    PyPutter::type.tp_clear = &PutterOp::py_clear;
+
+    PyPutter::type.tp_methods = Putter_methods;
+
+    if(PyType_Ready(&PyPutter::type))
+        throw std::runtime_error("failed to initialize PyPutter");
+
+    Py_INCREF((PyObject*)&PyPutter::type);
+    if(PyModule_AddObject(mod, "Putter", (PyObject*)&PyPutter::type)) {
+        Py_DECREF((PyObject*)&PyPutter::type);
+        throw std::runtime_error("failed to add p4p._p4p.Putter");
+    }
+
+    P4PTimeout = PyErr_NewException((char*)"p4p._p4p.TimeoutError", PyExc_RuntimeError, NULL);
+    if(!P4PTimeout)
+        throw std::runtime_error("failed to create p4p._p4p.TimeoutError");
+    Py_INCREF(P4PTimeout);
+    if(PyModule_AddObject(mod, "TimeoutError", P4PTimeout)) {
+        Py_DECREF(P4PTimeout);
+        throw std::runtime_error("failed to add p4p._p4p.TimeoutError");
+    }
+
+    PyDispatcher::buildType();
+    PyDispatcher::type.tp_flags = Py_TPFLAGS_DEFAULT|Py_TPFLAGS_BASETYPE;
+    PyDispatcher::type.tp_init = &Dispatcher::py_init;
+    PyDispatcher::type.tp_doc = "Dispatcher(workers=1, ordered=True)\n\n"
+            "Runs the callbacks of operations on worker threads instead of PVA threads.\n"
+            "Pass to Context(dispatcher=).  Each worker takes the GIL once for all callbacks queued.\n"
+            "When ordered, the callbacks of each Channel are made by one worker, in order.\n"
+            "Threads are started when first needed.\n"
+            "Workers are kept while any Context uses them, even if this object is collected.\n"
+            "close() stops them, and waits.";
+
+    PyDispatcher::type.tp_methods = Dispatcher_methods;
+
+    if(PyType_Ready(&PyDispatcher::type))
+        throw std::runtime_error("failed to initialize PyDispatcher");
+
+    Py_INCREF((PyObject*)&PyDispatcher::type);
+    if(PyModule_AddObject(mod, "Dispatcher", (PyObject*)&PyDispatcher::type)) {
+        Py_DECREF((PyObject*)&PyDispatcher::type);
+        throw std::runtime_error("failed to add p4p._p4p.Dispatcher");
+    }
+
+    PySelector::buildType();
+    PySelector::type.tp_flags = Py_TPFLAGS_DEFAULT|Py_TPFLAGS_HAVE_GC;
+    PySelector::type.tp_init = &Selector::py_init;
+    PySelector::type.tp_traverse = &Selector::py_traverse;
+    PySelector::type.tp_clear = &Selector::py_clear;
+
+    PySelector::type.tp_methods = Selector_methods;
+
+    if(PyType_Ready(&PySelector::type))
+        throw std::runtime_error("failed to initialize PySelector");
+
+    Py_INCREF((PyObject*)&PySelector::type);
+    if(PyModule_AddObject(mod, "Selector", (PyObject*)&PySelector::type)) {
+        Py_DECREF((PyObject*)&PySelector::type);
+        throw std::runtime_error("failed to add p4p._p4p.Selector");
+    }
+
 }
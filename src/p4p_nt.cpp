@@ -0,0 +1,174 @@
+/* Native helpers for the Normative Types wrappers in p4p.nt
+ */
+#include <stddef.h>
+
+#include "p4p.h"
+
+namespace {
+
+namespace pvd = epics::pvData;
+
+// a scalar sub-field, or 0 when absent or not a scalar
+template<typename T>
+T scalar_at(PyObject *value, const char *name)
+{
+    pvd::PVField *fld = P4PValue_lookup(value, name);
+    if(!fld || fld->getField()->getType()!=pvd::scalar)
+        return 0;
+    return static_cast<pvd::PVScalar*>(fld)->getAs<T>();
+}
+
+// NTURI Type by repr() of the query argument signature tuple.
+// One per distinct signature, ie. per RPC method called, so 64 holds those of most clients.
+// A client calling more keeps the Types of those it calls most recently.
+// never free'd as entries can't be released after python is finalized
+typedef LRUCache<std::string, PyRef> nturi_types_t;
+nturi_types_t *nturi_types; // guarded by GIL
+
+PyObject *nturi_type(PyObject *sig)
+{
+    if(!nturi_types)
+        nturi_types = new nturi_types_t(64u);
+
+    std::string key(PyString(PyRef(PyObject_Repr(sig)).get()).str());
+
+    PyRef *T = nturi_types->find(key);
+    if(T) {
+        PyObject *ret = T->get();
+        Py_INCREF(ret);
+        return ret;
+    }
+
+    PyRef spec(Py_BuildValue("[(ss)(ss)(ss)(s(sOO))]",
+                             "scheme", "s",
+                             "authority", "s",
+                             "path", "s",
+                             "query", "S", Py_None, sig));
+    PyRef args(Py_BuildValue("(O)", spec.get()));
+    PyRef kws(Py_BuildValue("{ss}", "id", "epics:nt/NTURI:1.0"));
+    PyRef type(PyObject_Call((PyObject*)P4PType_type, args.get(), kws.get()));
+
+    nturi_types->insert(key, type);
+
+    return type.release();
+}
+
+} // namespace
+
+PyObject* p4p_ntscalar_unwrap(PyObject *junk, PyObject *args)
+{
+    try {
+        PyObject *typemap, *value;
+        if(!PyArg_ParseTuple(args, "O!O!", &PyDict_Type, &typemap, P4PValue_type, &value))
+            return NULL;
+
+        pvd::PVField *fld = P4PValue_lookup(value, "value");
+        if(!fld)
+            return PyErr_Format(PyExc_ValueError, "NTScalar has no .value");
+
+        PyRef val(P4PValue_fetch(value, fld));
+
+        PyObject *T = PyDict_GetItem(typemap, (PyObject*)Py_TYPE(val.get()));
+        if(!T)
+            return PyErr_Format(PyExc_ValueError, "Can't unwrap value of type %s", Py_TYPE(val.get())->tp_name);
+
+        PyRef ret(PyObject_CallFunctionObjArgs(T, val.get(), NULL));
+
+        pvd::int64 sec = scalar_at<pvd::int64>(value, "timeStamp.secondsPastEpoch");
+        pvd::int32 nsec = scalar_at<pvd::int32>(value, "timeStamp.nanoseconds");
+
+        PyRef dict(PyObject_GetAttrString(ret.get(), "__dict__"));
+        PyRef severity(PyLong_FromLong(scalar_at<pvd::int32>(value, "alarm.severity")));
+        PyRef status(PyLong_FromLong(scalar_at<pvd::int32>(value, "alarm.status")));
+        PyRef stamp(Py_BuildValue("Li", (long long)sec, int(nsec)));
+        PyRef timestamp(PyFloat_FromDouble(sec + nsec*1e-9));
+
+        if(PyDict_SetItemString(dict.get(), "raw", value)
+                || PyDict_SetItemString(dict.get(), "severity", severity.get())
+                || PyDict_SetItemString(dict.get(), "status", status.get())
+                || PyDict_SetItemString(dict.get(), "raw_stamp", stamp.get())
+                || PyDict_SetItemString(dict.get(), "timestamp", timestamp.get()))
+            return NULL;
+
+        return ret.release();
+    }CATCH()
+    return NULL;
+}
+
+PyObject* p4p_nturi_encode(PyObject *junk, PyObject *args, PyObject *kws)
+{
+    try {
+        static const char* names[] = {"sig", "path", "query", "scheme", "authority", NULL};
+        PyObject *sig, *query;
+        const char *path, *scheme = "", *authority = "";
+        if(!PyArg_ParseTupleAndKeywords(args, kws, "O!sO!|ss", (char**)names,
+                                        &PyTuple_Type, &sig,
+                                        &path,
+                                        &PyDict_Type, &query,
+                                        &scheme, &authority))
+            return NULL;
+
+        PyRef type(nturi_type(sig));
+
+        pvd::PVStructurePtr V(pvd::getPVDataCreate()->createPVStructure(P4PType_unwrap(type.get())));
+        V->getSubFieldT<pvd::PVString>(1)->put(scheme);
+        V->getSubFieldT<pvd::PVString>(2)->put(authority);
+        V->getSubFieldT<pvd::PVString>(3)->put(path);
+
+        pvd::BitSet::shared_pointer I(new pvd::BitSet(V->getNextFieldOffset()));
+        PyRef ret(P4PValue_wrap(P4PValue_type, V, I));
+
+        if(PyObject_SetAttrString(ret.get(), "query", query))
+            return NULL;
+
+        // nothing marked, as when a Value is constructed from a dict
+        I->clear();
+
+        return ret.release();
+    }CATCH()
+    return NULL;
+}
+
+PyObject* p4p_nturi_type(PyObject *junk, PyObject *args)
+{
+    try {
+        PyObject *sig;
+        if(!PyArg_ParseTuple(args, "O!", &PyTuple_Type, &sig))
+            return NULL;
+
+        return nturi_type(sig);
+    }CATCH()
+    return NULL;
+}
+
+PyObject* p4p_nturi_decode(PyObject *junk, PyObject *args)
+{
+    try {
+        PyObject *value;
+        if(!PyArg_ParseTuple(args, "O!", P4PValue_type, &value))
+            return NULL;
+
+        pvd::PVStructurePtr V(P4PValue_unwrap(value));
+
+        pvd::PVStringPtr path(V->getSubField<pvd::PVString>("path"));
+        pvd::PVStructurePtr query(V->getSubField<pvd::PVStructure>("query"));
+        if(!path)
+            return PyErr_Format(PyExc_ValueError, "NTURI has no .path");
+
+        PyRef qdict(PyDict_New());
+
+        if(query) {
+            const pvd::StringArray& qnames(query->getStructure()->getFieldNames());
+            const pvd::PVFieldPtrArray& qflds(query->getPVFields());
+
+            for(size_t i=0; i<qflds.size(); i++) {
+                PyRef val(P4PValue_fetch(value, qflds[i].get()));
+                if(PyDict_SetItemString(qdict.get(), qnames[i].c_str(), val.get()))
+                    return NULL;
+            }
+        }
+
+        return Py_BuildValue("sO", path->get().c_str(), qdict.get());
+    }CATCH()
+    return NULL;
+}
@@ -1,5 +1,6 @@
 
 #include <map>
+#include <deque>
 
 #include <time.h>
 #include <stddef.h>
@@ -41,6 +42,10 @@ struct PyServerProvider :
     virtual ChannelProvider::shared_pointer sharedInstance() {
         return shared_from_this();
     }
+    // a client Context in this process uses the provider directly
+    virtual ChannelProvider::shared_pointer newInstance(const std::tr1::shared_ptr<pva::Configuration>&) {
+        return shared_from_this();
+    }
 
     virtual std::tr1::shared_ptr<pva::ChannelProvider> getChannelProvider() { return shared_from_this(); }
     virtual void cancel() {}
@@ -219,9 +224,13 @@ struct PyServerChannel :
             pva::ChannelRPCRequester::shared_pointer const & channelRPCRequester,
             pvd::PVStructure::shared_pointer const & pvRequest);
 
-//    virtual pva::ChannelGet::shared_pointer createChannelGet(
-//            const pva::ChannelGetRequester::shared_pointer &channelGetRequester,
-//            const pvd::PVStructure::shared_pointer &pvRequest);
+    virtual pva::ChannelGet::shared_pointer createChannelGet(
+            pva::ChannelGetRequester::shared_pointer const & channelGetRequester,
+            pvd::PVStructure::shared_pointer const & pvRequest);
+
+    virtual pva::Monitor::shared_pointer createMonitor(
+            pva::MonitorRequester::shared_pointer const & monitorRequester,
+            pvd::PVStructure::shared_pointer const & pvRequest);
 };
 
 // common base class for our operations
@@ -504,6 +513,167 @@ struct PyServerGet : public PyServerCommon<pva::ChannelGet>,
     }
 };
 
+// A subscription.  Python code post()s updates into a fixed number of elements,
+// each of which is in use until the client release()s it.
+struct PyServerMonitor : public pva::Monitor,
+                         public std::tr1::enable_shared_from_this<PyServerMonitor>
+{
+    POINTER_DEFINITIONS(PyServerMonitor);
+
+    struct SubData {
+        PyServerMonitor::shared_pointer mon;
+    };
+
+    typedef PyClassWrapper<SubData> Sub;
+
+    typedef std::deque<pva::MonitorElementPtr> elements_t;
+
+    const PyServerChannel::shared_pointer chan;
+    const pva::MonitorRequester::weak_pointer requester;
+    const pvd::Structure::const_shared_pointer type;
+    const pvd::PVStructure::const_shared_pointer pvRequest;
+
+    epicsMutex lock;
+    // guarded by lock
+    elements_t unused, queue;
+    bool running;
+
+    PyServerMonitor(const PyServerChannel::shared_pointer& chan,
+                    const pva::MonitorRequester::shared_pointer& requester,
+                    const pvd::Structure::const_shared_pointer& type,
+                    const pvd::PVStructure::const_shared_pointer& pvRequest,
+                    size_t nelements)
+        :chan(chan), requester(requester), type(type), pvRequest(pvRequest), running(false)
+    {
+        for(size_t i=0; i<nelements; i++)
+            unused.push_back(pva::MonitorElementPtr(new pva::MonitorElement(pvd::getPVDataCreate()->createPVStructure(type))));
+    }
+    virtual ~PyServerMonitor() {}
+
+    // call w/o GIL
+    void notify() {
+        pva::MonitorRequester::shared_pointer R(requester.lock());
+        if(R)
+            R->monitorEvent(shared_from_this());
+    }
+
+    virtual void destroy() { stop(); }
+
+    virtual pvd::Status start() {
+        bool pending;
+        {
+            Guard G(lock);
+            running = true;
+            pending = !queue.empty();
+        }
+        if(pending)
+            notify();
+        return pvd::Status::Ok;
+    }
+
+    virtual pvd::Status stop() {
+        Guard G(lock);
+        running = false;
+        return pvd::Status::Ok;
+    }
+
+    virtual pva::MonitorElementPtr poll() {
+        pva::MonitorElementPtr ret;
+        Guard G(lock);
+        if(running && !queue.empty()) {
+            ret = queue.front();
+            queue.pop_front();
+        }
+        return ret;
+    }
+
+    virtual void release(const pva::MonitorElementPtr& elem) {
+        Guard G(lock);
+        unused.push_back(elem);
+    }
+
+    // python methods of the SubData class
+
+    static PyObject* sub_post(PyObject *self, PyObject *args, PyObject *kwds)
+    {
+        PyObject *data;
+        const char *names[] = {"value", NULL};
+        if(!PyArg_ParseTupleAndKeywords(args, kwds, "O!", (char**)names, P4PValue_type, &data))
+            return NULL;
+
+        TRACE("ENTER");
+        Sub::reference_type SELF = Sub::unwrap(self);
+        try {
+            PyServerMonitor& mon = *SELF.mon;
+            pvd::PVStructure::shared_pointer value(P4PValue_unwrap(data));
+            pvd::BitSet::shared_pointer changed(P4PValue_unwrap_bitset(data));
+
+            if(value->getStructure()!=mon.type)
+                return PyErr_Format(PyExc_ValueError, "post() Value must have the channelType");
+
+            pva::MonitorElementPtr elem;
+            {
+                Guard G(mon.lock);
+                if(mon.unused.empty())
+                    Py_RETURN_FALSE;
+                elem = mon.unused.front();
+                mon.unused.pop_front();
+            }
+
+            elem->pvStructurePtr->copyUnchecked(*value);
+            *elem->changedBitSet = *changed;
+            elem->overrunBitSet->clear();
+
+            bool running;
+            {
+                Guard G(mon.lock);
+                mon.queue.push_back(elem);
+                running = mon.running;
+            }
+            if(running) {
+                PyUnlock U;
+                mon.notify();
+            }
+
+            TRACE("SUCCESS");
+            Py_RETURN_TRUE;
+        }CATCH()
+        TRACE("ERROR");
+        return NULL;
+    }
+
+    static PyObject* sub_request(PyObject *self)
+    {
+        TRACE("ENTER");
+        Sub::reference_type SELF = Sub::unwrap(self);
+        try {
+            const pvd::PVStructure::const_shared_pointer& R = SELF.mon->pvRequest;
+            if(!R)
+                Py_RETURN_NONE;
+            // a copy, as the client may still use this
+            pvd::PVStructure::shared_pointer V(pvd::getPVDataCreate()->createPVStructure(R->getStructure()));
+            V->copyUnchecked(*R);
+            return P4PValue_wrap(P4PValue_type, V);
+        }CATCH()
+        return NULL;
+    }
+
+    static PyObject* sub_done(PyObject *self)
+    {
+        TRACE("ENTER");
+        Sub::reference_type SELF = Sub::unwrap(self);
+        try {
+            pva::MonitorRequester::shared_pointer R(SELF.mon->requester.lock());
+            if(R) {
+                PyUnlock U;
+                R->unlisten(SELF.mon);
+            }
+            Py_RETURN_NONE;
+        }CATCH()
+        return NULL;
+    }
+};
+
 pva::Channel::shared_pointer
 PyServerProvider::createChannel(std::string const & channelName,
                                                    pva::ChannelRequester::shared_pointer const & channelRequester,
@@ -530,6 +700,8 @@ PyServerProvider::createChannel(std::string const & channelName,
             ret.reset(new PyServerChannel(shared_from_this(),channelRequester, channelName, handler));
             // handler consumed now
             channelRequester->channelCreated(pvd::Status::Ok, ret);
+            // a client Context in this process waits for this.  The server ignores it.
+            channelRequester->channelStateChange(ret, pva::Channel::CONNECTED);
         }
     } catch(std::exception& e) {
         channelRequester->channelCreated(pvd::Status(pvd::Status::STATUSTYPE_ERROR, e.what()),
@@ -549,20 +721,76 @@ PyServerChannel::createChannelRPC(
     channelRPCRequester->channelRPCConnect(pvd::Status::Ok, ret);
     return ret;
 }
-/*
+
 pva::ChannelGet::shared_pointer
 PyServerChannel::createChannelGet(
-        const pva::ChannelGetRequester::shared_pointer &channelGetRequester,
-        const pvd::PVStructure::shared_pointer &pvRequest)
+        pva::ChannelGetRequester::shared_pointer const & channelGetRequester,
+        pvd::PVStructure::shared_pointer const & pvRequest)
 {
     TRACE("ENTER");
     pvd::Structure::const_shared_pointer gtype(getType());
-    pva::ChannelGet::shared_pointer ret(new PyServerGet(shared_from_this(), pvRequest, channelGetRequester));
+    PyServerGet::shared_pointer ret(new PyServerGet(shared_from_this(), pvRequest, channelGetRequester));
+    ret->type = gtype;
     if(gtype)
-        channelGetRequester->channelGetConnect(pvd::Status::Ok, ret);
+        channelGetRequester->channelGetConnect(pvd::Status::Ok, ret, gtype);
+    else
+        channelGetRequester->channelGetConnect(pvd::Status(pvd::Status::STATUSTYPE_ERROR, "Channel has no channelType"),
+                                               ret, gtype);
+    return ret;
+}
+pva::Monitor::shared_pointer
+PyServerChannel::createMonitor(
+        pva::MonitorRequester::shared_pointer const & monitorRequester,
+        pvd::PVStructure::shared_pointer const & pvRequest)
+{
+    TRACE("ENTER");
+    PyServerMonitor::shared_pointer ret;
+    pvd::Structure::const_shared_pointer mtype(getType());
+
+    bool ok;
+    {
+        PyLock L;
+        ok = handler.ref.get() && PyObject_HasAttrString(handler.ref.get(), "monitor");
+    }
+    if(!ok || !mtype) {
+        monitorRequester->monitorConnect(pvd::Status(pvd::Status::STATUSTYPE_ERROR,
+                                                     ok ? "Channel has no channelType" : "Channel does not support monitor"),
+                                         ret, mtype);
+        return ret;
+    }
+
+    // the number of updates which may be in flight
+    size_t nelements = 4u;
+    pvd::PVScalar::shared_pointer Q(pvRequest ? pvRequest->getSubField<pvd::PVScalar>("record._options.queueSize") : pvd::PVScalar::shared_pointer());
+    if(Q) {
+        try {
+            nelements = std::max(1, Q->getAs<pvd::int32>());
+        } catch(std::exception&) {
+            // keep default
+        }
+    }
+
+    ret.reset(new PyServerMonitor(shared_from_this(), monitorRequester, mtype, pvRequest, nelements));
+    monitorRequester->monitorConnect(pvd::Status::Ok, ret, mtype);
+
+    PyLock L;
+    try {
+        PyRef args(PyTuple_New(0));
+        PyRef sub(PyServerMonitor::Sub::type.tp_new(&PyServerMonitor::Sub::type, args.get(), 0));
+
+        PyServerMonitor::Sub::unwrap(sub.get()).mon = ret;
+
+        PyRef junk(PyObject_CallMethod(handler.ref.get(), "monitor", "O", sub.get()));
+    } catch(std::exception& e) {
+        if(PyErr_Occurred()) {
+            PyErr_Print();
+            PyErr_Clear();
+        }
+        std::cerr<<"Error in monitor() of "<<name<<" : "<<e.what()<<"\n";
+    }
     return ret;
 }
-*/
+
 typedef std::map<std::string, PyServerProvider::shared_pointer> pyproviders_t;
 pyproviders_t* pyproviders;
 
@@ -696,6 +924,27 @@ PyTypeObject PyServerGet::Reply::type = {
     sizeof(PyServerGet::Reply),
 };
 
+static struct PyMethodDef PyServerMonitor_methods[] = {
+    {"post", (PyCFunction)PyServerMonitor::sub_post, METH_VARARGS|METH_KEYWORDS,
+     "post(value) -> bool\n"
+     "Send an update, a Value of the channelType.\n"
+     "Returns False, and sends nothing, when all queue elements are in use by the client."},
+    {"pvRequest", (PyCFunction)PyServerMonitor::sub_request, METH_NOARGS,
+     "pvRequest() -> Value\n"
+     "The client's request, including any record._options.  None if there was none."},
+    {"done", (PyCFunction)PyServerMonitor::sub_done, METH_NOARGS,
+     "done()\n"
+     "End the subscription, once the client has received all updates"},
+    {NULL}
+};
+
+template<>
+PyTypeObject PyServerMonitor::Sub::type = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "_p4p.MonitorSub",
+    sizeof(PyServerMonitor::Sub),
+};
+
 } // namespace
 
 struct PyMethodDef P4P_methods[] = {
@@ -711,6 +960,18 @@ struct PyMethodDef P4P_methods[] = {
      ":returns: tuple of version number components for PVData"},
     {"pvaVersion", (PyCFunction)p4p_pva_version, METH_NOARGS,
      ":returns: tuple of version number components for PVData"},
+    {"_ntscalar_unwrap", (PyCFunction)p4p_ntscalar_unwrap, METH_VARARGS,
+     "_ntscalar_unwrap(typeMap, value)\n"
+     "NTScalar.unwrap() implementation"},
+    {"_nturi_encode", (PyCFunction)p4p_nturi_encode, METH_VARARGS|METH_KEYWORDS,
+     "_nturi_encode(sig, path, query, scheme='', authority='') -> Value\n"
+     "Build NTURI.  sig is a tuple of (name, type code) for the query arguments"},
+    {"_nturi_type", (PyCFunction)p4p_nturi_type, METH_VARARGS,
+     "_nturi_type(sig) -> Type\n"
+     "The NTURI Type built by _nturi_encode() for this signature"},
+    {"_nturi_decode", (PyCFunction)p4p_nturi_decode, METH_VARARGS,
+     "_nturi_decode(value) -> ('path', {'arg':val})\n"
+     "Unpack NTURI"},
     {NULL}
 };
 
@@ -730,12 +991,21 @@ void p4p_server_provider_register(PyObject *mod)
 
     PyServerGet::Reply::type.tp_methods = PyServerGet_methods;
 
+    PyServerMonitor::Sub::buildType();
+    PyServerMonitor::Sub::type.tp_flags = Py_TPFLAGS_DEFAULT;
+    // No init.  This type can't be created by python code
+
+    PyServerMonitor::Sub::type.tp_methods = PyServerMonitor_methods;
+
     if(PyType_Ready(&PyServerRPC::Reply::type))
         throw std::runtime_error("failed to initialize RPCReply");
 
     if(PyType_Ready(&PyServerGet::Reply::type))
         throw std::runtime_error("failed to initialize GetReply");
 
+    if(PyType_Ready(&PyServerMonitor::Sub::type))
+        throw std::runtime_error("failed to initialize MonitorSub");
+
     Py_INCREF((PyObject*)&PyServerRPC::Reply::type);
     if(PyModule_AddObject(mod, "RPCReply", (PyObject*)&PyServerRPC::Reply::type)) {
         Py_DECREF((PyObject*)&PyServerRPC::Reply::type);
@@ -747,4 +1017,10 @@ void p4p_server_provider_register(PyObject *mod)
         Py_DECREF((PyObject*)&PyServerGet::Reply::type);
         throw std::runtime_error("failed to add _p4p.GetReply");
     }
+
+    Py_INCREF((PyObject*)&PyServerMonitor::Sub::type);
+    if(PyModule_AddObject(mod, "MonitorSub", (PyObject*)&PyServerMonitor::Sub::type)) {
+        Py_DECREF((PyObject*)&PyServerMonitor::Sub::type);
+        throw std::runtime_error("failed to add _p4p.MonitorSub");
+    }
 }
@@ -1,5 +1,10 @@
 
+#include <map>
+#include <vector>
+#include <utility>
+
 #include <stddef.h>
+#include <string.h>
 
 #include "p4p.h"
 
@@ -12,12 +17,62 @@ namespace {
 
 namespace pvd = epics::pvData;
 
+/* Field index paths of a Structure by (dotted) name, relative to the structure.
+ * Computed once per type to replace the per-level search by name
+ * of PVStructure::getSubField(), and the search by offset of getSubFieldT().
+ */
+struct Layout {
+    // keeps the type alive, so the cache key is not re-used
+    pvd::StructureConstPtr type;
+    // index in getPVFields() at each level
+    typedef std::vector<size_t> path_t;
+    typedef std::map<std::string, path_t> paths_t;
+    paths_t paths;
+
+    explicit Layout(const pvd::StructureConstPtr& type) :type(type) {
+        path_t path;
+        build(type.get(), std::string(), path);
+    }
+
+    void build(const pvd::Structure *S, const std::string& prefix, path_t& path) {
+        const pvd::StringArray& names(S->getFieldNames());
+        const pvd::FieldConstPtrArray& flds(S->getFields());
+
+        for(size_t i=0; i<flds.size(); i++) {
+            std::string name(prefix+names[i]);
+            path.push_back(i);
+            paths[name] = path;
+            if(flds[i]->getType()==pvd::structure)
+                build(static_cast<const pvd::Structure*>(flds[i].get()), name+".", path);
+            path.pop_back();
+        }
+    }
+
+    static std::tr1::shared_ptr<const Layout> lookup(const pvd::StructureConstPtr& type);
+};
+
 struct Value {
     // structure we are wrapping
     pvd::PVStructure::shared_pointer V;
     // which fields of this structure have been initialized w/ non-default values
     // NULL when not tracking, treated as bit 0 set (aka all initialized)
     pvd::BitSet::shared_pointer I;
+    // which fields of a monitor update had intermediate updates squashed by the server
+    // NULL when not known, treated as empty
+    pvd::BitSet::shared_pointer O;
+    // when set, assignments which don't change a scalar or array field
+    // leave it un-marked in I
+    bool compare;
+
+    // cached by lookup()
+    std::tr1::shared_ptr<const Layout> layout;
+    // keeps storage of V valid (eg. a borrowed MonitorElement)
+    std::tr1::shared_ptr<void> holder;
+
+    Value() :compare(false) {}
+
+    // find sub-field by name, or NULL
+    pvd::PVField* lookup(const std::string& name);
 
     void storefld(epics::pvData::PVField *fld,
                const epics::pvData::Field *ftype,
@@ -69,12 +124,193 @@ NPY_TYPES ntype(pvd::ScalarType t) {
     throw std::runtime_error(SB()<<"Unable to map scalar type '"<<(int)t<<"'");
 }
 
-//pvd::ScalarType ptype(NPY_TYPES t) {
-//    for(const npmap *p = np2pvd; p->npy!=NPY_NOTYPE; p++) {
-//        if(p->npy==t) return p->pvd;
-//    }
-//    throw std::runtime_error(SB()<<"Unable to map npy type '"<<(int)t<<"'");
-//}
+// map npy type (or an equivalent, eg. NPY_LONGLONG) to pvd type
+bool ptype(int t, pvd::ScalarType *out) {
+    for(const npmap *p = np2pvd; p->npy!=NPY_NOTYPE; p++) {
+        if(PyArray_EquivTypenums(p->npy, t)) {
+            *out = p->pvd;
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Cache of python strings for string field values, which often repeat
+ * (eg. units, enum choices, descriptions, table labels).
+ * Strings are keyed by content.  String arrays by the (immutable) buffer
+ * they reference, which the cache keeps alive.
+ * Only accessed with the GIL held.
+ */
+struct InternCache {
+    // Entries are charged their string bytes.  Evicting the least recently used
+    // keeps the strings of PVs being updated, while one-off values age out.
+    typedef LRUCache<std::string, PyRef> strings_t;
+    strings_t strings;
+
+    typedef std::pair<const std::string*, size_t> array_key;
+    struct array_ent {
+        pvd::shared_vector<const std::string> arr;
+        PyRef strs; // tuple
+    };
+    typedef LRUCache<array_key, array_ent> arrays_t;
+    arrays_t arrays;
+
+    // limits
+    size_t maxLength, // longer strings not cached
+           maxBytes;  // of strings, and of string arrays
+
+    size_t nStrHit, nStrMiss, nArrHit, nArrMiss, nFlush;
+
+    InternCache() :strings(1024u*1024u), arrays(1024u*1024u), maxLength(128u), maxBytes(1024u*1024u)
+      ,nStrHit(0u), nStrMiss(0u), nArrHit(0u), nArrMiss(0u), nFlush(0u)
+    {}
+
+    // string bytes (approximately) referenced by entries
+    size_t bytes() const { return strings.total + arrays.total; }
+
+    void flush() {
+        strings.clear();
+        arrays.clear();
+        strings.setLimit(maxBytes);
+        arrays.setLimit(maxBytes);
+        nFlush++;
+    }
+
+    PyObject *string(const std::string& val) {
+        if(val.size() > maxLength)
+            return PyUnicode_FromStringAndSize(val.c_str(), val.size());
+
+        PyRef *ent = strings.find(val);
+        if(ent) {
+            nStrHit++;
+            PyObject *ret = ent->get();
+            Py_INCREF(ret);
+            return ret;
+        }
+        nStrMiss++;
+
+        PyRef ret(PyUnicode_FromStringAndSize(val.c_str(), val.size()));
+        strings.insert(val, ret, val.size());
+        return ret.release();
+    }
+
+    PyObject *list(const pvd::shared_vector<const std::string>& arr) {
+        array_key key(arr.data(), arr.size());
+        array_ent *ent = arrays.find(key);
+
+        if(ent) {
+            nArrHit++;
+            return PySequence_List(ent->strs.get());
+        }
+        nArrMiss++;
+
+        PyRef strs(PyTuple_New(arr.size()));
+        size_t nbytes = 0u;
+
+        for(size_t i=0; i<arr.size(); i++) {
+            PyTuple_SET_ITEM(strs.get(), i, string(arr[i]));
+            nbytes += arr[i].size();
+        }
+
+        // large arrays would evict many others
+        if(nbytes <= maxBytes/4u) {
+            array_ent nent = {arr, strs};
+            arrays.insert(key, nent, nbytes);
+        }
+
+        return PySequence_List(strs.get());
+    }
+};
+
+// never free'd as entries can't be released after python is finalized
+InternCache *intern;
+
+// One entry per distinct type.  The types of many PVs repeat (eg. NTScalar double),
+// so a few hundred cover most applications.  A stream of one-off types (eg. RPC replies)
+// evicts only each other, while the types of PVs in use stay.
+typedef LRUCache<const pvd::Structure*, std::tr1::shared_ptr<const Layout> > layouts_t;
+layouts_t layouts(1024u); // guarded by GIL
+
+std::tr1::shared_ptr<const Layout> Layout::lookup(const pvd::StructureConstPtr& type)
+{
+    std::tr1::shared_ptr<const Layout> *ent = layouts.find(type.get());
+    if(ent)
+        return *ent;
+
+    return layouts.insert(type.get(), std::tr1::shared_ptr<const Layout>(new Layout(type)));
+}
+
+pvd::PVField* Value::lookup(const std::string& name)
+{
+    if(!layout)
+        layout = Layout::lookup(V->getStructure());
+
+    Layout::paths_t::const_iterator it(layout->paths.find(name));
+    if(it!=layout->paths.end()) {
+        const Layout::path_t& path = it->second;
+        pvd::PVStructure *S = V.get();
+        for(size_t i=0; i+1<path.size(); i++)
+            S = static_cast<pvd::PVStructure*>(S->getPVFields()[path[i]].get());
+        return S->getPVFields()[path.back()].get();
+    }
+
+    if(name.find('[')!=name.npos) // eg. structure array element
+        return V->getSubField(name).get();
+
+    return NULL;
+}
+
+// Snapshot of a scalar field value, to detect no-op assignment
+// Lives on the stack, and is empty until take()n.
+struct ScalarSnapshot {
+    bool valid;
+    pvd::ScalarType type;
+    union {
+        double dval;
+        pvd::int64 ival;
+        pvd::uint64 uval;
+    };
+    std::string sval;
+
+    ScalarSnapshot() :valid(false) {}
+
+    void take(pvd::PVScalar *F)
+    {
+        valid = true;
+        type = F->getScalar()->getScalarType();
+        switch(type) {
+        case pvd::pvString: sval = F->getAs<std::string>(); break;
+        case pvd::pvFloat:
+        case pvd::pvDouble: dval = F->getAs<double>(); break;
+        case pvd::pvUInt:
+        case pvd::pvULong: uval = F->getAs<pvd::uint64>(); break;
+        default: ival = F->getAs<pvd::int64>(); break;
+        }
+    }
+
+    bool same(pvd::PVScalar *F) const {
+        switch(type) {
+        case pvd::pvString: return sval==F->getAs<std::string>();
+        case pvd::pvFloat:
+        case pvd::pvDouble: {
+            // bitwise, so that NaN compares equal to NaN
+            double cur = F->getAs<double>();
+            return memcmp(&dval, &cur, sizeof(cur))==0;
+        }
+        case pvd::pvUInt:
+        case pvd::pvULong: return uval==F->getAs<pvd::uint64>();
+        default: return ival==F->getAs<pvd::int64>();
+        }
+    }
+};
+
+// compare numeric array field with a buffer of the same element type
+bool same_array(pvd::PVScalarArray *F, const void *data, size_t nbytes)
+{
+    pvd::shared_vector<const void> cur;
+    F->getAs(cur);
+    return cur.size()==nbytes && (nbytes==0 || memcmp(cur.data(), data, nbytes)==0);
+}
 
 
 void Value::store_struct(pvd::PVStructure* fld,
@@ -206,6 +442,10 @@ void Value::storefld(pvd::PVField* fld,
     switch(ftype->getType()) {
     case pvd::scalar: {
         pvd::PVScalar* F = static_cast<pvd::PVScalar*>(fld);
+        ScalarSnapshot prev;
+        if(compare)
+            prev.take(F);
+
         if(PyBool_Check(obj)) {
             F->putFrom<pvd::boolean>(obj==Py_True);
 #if PY_MAJOR_VERSION < 3
@@ -229,6 +469,9 @@ void Value::storefld(pvd::PVField* fld,
         } else {
             throw std::runtime_error(SB()<<"Can't assign scalar field "<<fld->getFullName()<<" with "<<Py_TYPE(obj)->tp_name);
         }
+
+        if(prev.valid && prev.same(F))
+            return;
     }
         if(bset)
             bset->set(fld_offset);
@@ -264,10 +507,37 @@ void Value::storefld(pvd::PVField* fld,
                 }
             }
 
+            if(compare) {
+                pvd::shared_vector<const std::string> cur(static_cast<pvd::PVStringArray*>(F)->view());
+                if(cur.size()==vec.size() && std::equal(vec.begin(), vec.end(), cur.begin()))
+                    return;
+            }
+
             static_cast<pvd::PVStringArray*>(F)->replace(pvd::freeze(vec));
 
         } else {
             NPY_TYPES nptype(ntype(etype));
+            pvd::ScalarType stype;
+
+            if(PyArray_Check(obj) && PyArray_NDIM(obj)==1
+                    && PyArray_ISCARRAY_RO(obj) && PyArray_ISNOTSWAPPED(obj)
+                    && PyArray_TYPE(obj)!=nptype && ptype(PyArray_TYPE(obj), &stype))
+            {
+                // convert directly from the caller's buffer, instead of
+                // through a temporary numpy array of the field type
+                size_t count = PyArray_DIM(obj, 0);
+                pvd::shared_vector<void> buf(P4PArray_alloc(etype, count));
+
+                P4PArray_convert(etype, buf.data(), stype, PyArray_DATA(obj), count);
+
+                if(compare && same_array(F, buf.data(), buf.size()))
+                    return;
+
+                F->putFrom(pvd::freeze(buf));
+                if(bset)
+                    bset->set(fld_offset);
+                return;
+            }
 
             PyRef V(PyArray_FromAny(obj, PyArray_DescrFromType(nptype), 0, 0,
                                     NPY_CARRAY_RO, NULL));
@@ -275,16 +545,21 @@ void Value::storefld(pvd::PVField* fld,
             if(PyArray_NDIM(V.get())!=1)
                 throw std::runtime_error("Only 1-d array can be assigned");
 
+            if(compare && same_array(F, PyArray_DATA(V.get()), PyArray_NBYTES(V.get())))
+                return;
+
             // TODO: detect reference cycles so we can avoid this copy
             //       Cycles can be created only if we both store and fetch
             //       by reference.
-            pvd::shared_vector<void> buf(pvd::ScalarTypeFunc::allocArray(etype, PyArray_DIM(V.get(), 0)));
+            pvd::shared_vector<void> buf(P4PArray_alloc(etype, PyArray_DIM(V.get(), 0)));
 
             memcpy(buf.data(), PyArray_DATA(V.get()), PyArray_NBYTES(V.get()));
 
             F->putFrom(pvd::freeze(buf));
         }
     }
+        if(bset)
+            bset->set(fld_offset);
         return;
     case pvd::structure: {
         pvd::PVStructure *F = static_cast<pvd::PVStructure*>(fld);
@@ -365,7 +640,7 @@ PyObject *Value::fetchfld(pvd::PVField *fld,
         case pvd::pvDouble:
             return PyFloat_FromDouble(F->getAs<double>());
         case pvd::pvString:
-            return PyUnicode_FromString(F->getAs<std::string>().c_str());
+            return intern->string(static_cast<pvd::PVString*>(F)->get());
         }
     }
         break;
@@ -377,31 +652,13 @@ PyObject *Value::fetchfld(pvd::PVField *fld,
         if(etype==pvd::pvString) {
             pvd::shared_vector<const std::string> arr(static_cast<pvd::PVStringArray*>(F)->view());
 
-            PyRef list(PyList_New(arr.size()));
-
-            for(size_t i=0; i<arr.size(); i++) {
-                PyRef S(PyUnicode_FromString(arr[i].c_str()));
-
-                PyList_SET_ITEM(list.get(), i, S.release());
-            }
-
-            return list.release();
+            return intern->list(arr);
 
         } else {
-            NPY_TYPES npy(ntype(etype));
-
             pvd::shared_vector<const void> arr;
             F->getAs(arr);
-            size_t esize = pvd::ScalarTypeFunc::elementSize(etype);
-            npy_intp dim = arr.size()/esize;
-
-            PyRef pyarr(PyArray_New(&PyArray_Type, 1, &dim, npy, NULL, (void*)arr.data(),
-                                    esize, NPY_CARRAY_RO, NULL));
 
-            PyObject *base = P4PArray_make(arr);
-            ((PyArrayObject*)pyarr.get())->base = base;
-
-            return pyarr.release();
+            return P4PValue_ndarray(arr);
         }
     }
         break;
@@ -428,7 +685,11 @@ PyObject *Value::fetchfld(pvd::PVField *fld,
 
         } else {
             PyObject *self = P4PValue::wrap(this);
-            return P4PValue_wrap(Py_TYPE(self), std::tr1::static_pointer_cast<pvd::PVStructure>(F->shared_from_this()), bset);
+            PyRef ret(P4PValue_wrap(Py_TYPE(self), std::tr1::static_pointer_cast<pvd::PVStructure>(F->shared_from_this()), bset));
+            P4PValue::unwrap(ret.get()).compare = compare;
+            P4PValue::unwrap(ret.get()).holder = holder;
+            P4PValue::unwrap(ret.get()).O = O;
+            return ret.release();
 
         }
     }
@@ -477,14 +738,21 @@ PyObject *Value::fetchfld(pvd::PVField *fld,
 int P4PValue_init(PyObject *self, PyObject *args, PyObject *kwds)
 {
     TRY {
-        const char *names[] = {"type", "value", "clone", NULL};
+        const char *names[] = {"type", "value", "clone", "compare", NULL};
         PyObject *type = NULL, *value = Py_None;
         PyObject *clone = NULL;
-        if(!PyArg_ParseTupleAndKeywords(args, kwds, "|O!OO!", (char**)names,
+        PyObject *compare = Py_False;
+        if(!PyArg_ParseTupleAndKeywords(args, kwds, "|O!OO!O", (char**)names,
                                         P4PType_type, &type,
                                         &value,
-                                        P4PValue_type, &clone))
+                                        P4PValue_type, &clone,
+                                        &compare))
+            return -1;
+
+        int cmp = PyObject_IsTrue(compare);
+        if(cmp<0)
             return -1;
+        SELF.compare = cmp;
 
         if(SELF.V) {
             // magic construction w/ P4PValue_wrap()
@@ -504,6 +772,7 @@ int P4PValue_init(PyObject *self, PyObject *args, PyObject *kwds)
 
         } else if(clone) {
             SELF.V = P4PValue::unwrap(clone).V;
+            SELF.holder = P4PValue::unwrap(clone).holder;
             SELF.I.reset(new pvd::BitSet(SELF.V->getNextFieldOffset()));
 
         } else {
@@ -520,11 +789,11 @@ int P4PValue_setattr(PyObject *self, PyObject *name, PyObject *value)
 {
     TRY {
         PyString S(name);
-        pvd::PVFieldPtr fld = SELF.V->getSubField(S.str());
+        pvd::PVField *fld = SELF.lookup(S.str());
         if(!fld)
             return PyObject_GenericSetAttr((PyObject*)self, name, value);
 
-        SELF.storefld(fld.get(),
+        SELF.storefld(fld,
                        fld->getField().get(),
                        value,
                        SELF.I);
@@ -539,12 +808,12 @@ PyObject* P4PValue_getattr(PyObject *self, PyObject *name)
 {
     TRY {
         PyString S(name);
-        pvd::PVFieldPtr fld = SELF.V->getSubField(S.str());
+        pvd::PVField *fld = SELF.lookup(S.str());
         if(!fld)
             return PyObject_GenericGetAttr((PyObject*)self, name);
 
         // return sub-struct as Value
-        return SELF.fetchfld(fld.get(),
+        return SELF.fetchfld(fld,
                              fld->getField().get(),
                              SELF.I,
                              false);
@@ -578,9 +847,9 @@ PyObject* P4PValue_repr(PyObject *self)
                 return NULL;
         }
 
-        pvd::PVFieldPtr val(SELF.V->getSubField("value"));
-        if(!val) {
-            val = SELF.V->getSubField(SELF.V->getFieldOffset()+1);
+        pvd::PVField *val = SELF.lookup("value");
+        if(!val && !SELF.V->getPVFields().empty()) {
+            val = SELF.V->getPVFields()[0].get();
         }
 
         if(val) {
@@ -588,7 +857,7 @@ PyObject* P4PValue_repr(PyObject *self)
             if(PyDict_SetItemString(args.get(), "name", S.get()))
                 return NULL;
 
-            PyRef V(SELF.fetchfld(val.get(), val->getField().get(), pvd::BitSetPtr(), true));
+            PyRef V(SELF.fetchfld(val, val->getField().get(), pvd::BitSetPtr(), true));
             if(PyDict_SetItemString(args.get(), "val", V.get()))
                 return NULL;
 
@@ -612,11 +881,11 @@ PyObject* P4PValue_toList(PyObject *self, PyObject *args)
         if(!PyArg_ParseTuple(args, "|z", &name))
             return NULL;
 
-        pvd::PVFieldPtr fld;
+        pvd::PVField *fld;
         if(name)
-            fld = SELF.V->getSubField(name);
+            fld = SELF.lookup(name);
         else
-            fld = SELF.V; // name==NULL converts entire structure
+            fld = SELF.V.get(); // name==NULL converts entire structure
 
         if(!fld) {
             PyErr_SetString(PyExc_KeyError, name ? name : "<null>"); // should never actually be null
@@ -624,7 +893,7 @@ PyObject* P4PValue_toList(PyObject *self, PyObject *args)
         }
 
         // return sub-struct as list of tuple
-        return SELF.fetchfld(fld.get(),
+        return SELF.fetchfld(fld,
                              fld->getField().get(),
                              SELF.I,
                              true);
@@ -641,11 +910,11 @@ PyObject* P4PValue_items(PyObject *self, PyObject *args)
         if(!PyArg_ParseTuple(args, "|z", &name))
             return NULL;
 
-        pvd::PVFieldPtr fld;
+        pvd::PVField *fld;
         if(name)
-            fld = SELF.V->getSubField(name);
+            fld = SELF.lookup(name);
         else
-            fld = SELF.V; // name==NULL converts entire structure
+            fld = SELF.V.get(); // name==NULL converts entire structure
 
         if(!fld) {
             PyErr_SetString(PyExc_KeyError, name ? name : "<null>"); // should never actually be null
@@ -653,7 +922,7 @@ PyObject* P4PValue_items(PyObject *self, PyObject *args)
         }
 
         // return sub-struct as list of tuple, not recursive
-        return SELF.fetchfld(fld.get(),
+        return SELF.fetchfld(fld,
                              fld->getField().get(),
                              SELF.I,
                              true, false);
@@ -670,9 +939,10 @@ PyObject *P4PValue_select(PyObject *self, PyObject *args, PyObject *kwds)
         if(!PyArg_ParseTupleAndKeywords(args, kwds, "sz", (char**)names, &name, &sel))
             return NULL;
 
-        pvd::PVUnionPtr fld(SELF.V->getSubField<pvd::PVUnion>(name));
-        if(!fld)
+        pvd::PVField *F = SELF.lookup(name);
+        if(!F || F->getField()->getType()!=pvd::union_)
             return PyErr_Format(PyExc_KeyError, "%s", name);
+        pvd::PVUnion *fld = static_cast<pvd::PVUnion*>(F);
 
         if(!sel) {
             fld->select(fld->UNDEFINED_INDEX);
@@ -697,14 +967,14 @@ PyObject *P4PValue_get(PyObject *self, PyObject *args)
         if(!PyArg_ParseTuple(args, "s|O", &name, &defval))
             return NULL;
 
-        pvd::PVFieldPtr fld = SELF.V->getSubField(name);
+        pvd::PVField *fld = SELF.lookup(name);
         if(!fld) {
             Py_INCREF(defval);
             return defval;
         }
 
         // return sub-struct as Value
-        return SELF.fetchfld(fld.get(),
+        return SELF.fetchfld(fld,
                              fld->getField().get(),
                              SELF.I,
                              false);
@@ -712,6 +982,62 @@ PyObject *P4PValue_get(PyObject *self, PyObject *args)
     return NULL;
 }
 
+PyObject *P4PValue_getarray(PyObject *self, PyObject *args, PyObject *kwds)
+{
+    TRY {
+        static const char *names[] = {"field", "dtype", NULL};
+        const char *name;
+        PyObject *dtype = Py_None;
+        if(!PyArg_ParseTupleAndKeywords(args, kwds, "s|O", (char**)names, &name, &dtype))
+            return NULL;
+
+        pvd::PVField *F = SELF.lookup(name);
+        if(!F || F->getField()->getType()!=pvd::scalarArray)
+            return PyErr_Format(PyExc_KeyError, "No array field %s", name);
+        pvd::PVScalarArray *fld = static_cast<pvd::PVScalarArray*>(F);
+
+        pvd::ScalarType etype(fld->getScalarArray()->getElementType());
+
+        if(dtype==Py_None) {
+            // no conversion
+            return SELF.fetchfld(fld,
+                                 fld->getField().get(),
+                                 SELF.I,
+                                 false);
+        } else if(etype==pvd::pvString) {
+            return PyErr_Format(PyExc_TypeError, "dtype= not supported for string array %s", name);
+        }
+
+        PyArray_Descr *descr = NULL;
+        if(!PyArray_DescrConverter(dtype, &descr))
+            return NULL;
+        PyRef D((PyObject*)descr);
+
+        pvd::ScalarType dest;
+        if(!ptype(descr->type_num, &dest))
+            return PyErr_Format(PyExc_TypeError, "dtype= must be a numeric type");
+
+        if(dest==etype) {
+            // already the requested type, so no copy
+            return SELF.fetchfld(fld,
+                                 fld->getField().get(),
+                                 SELF.I,
+                                 false);
+        }
+
+        pvd::shared_vector<const void> arr;
+        fld->getAs(arr);
+        npy_intp count = arr.size()/pvd::ScalarTypeFunc::elementSize(etype);
+
+        PyRef pyarr(PyArray_SimpleNew(1, &count, descr->type_num));
+
+        P4PArray_convert(dest, PyArray_DATA(pyarr.get()), etype, arr.data(), count);
+
+        return pyarr.release();
+    }CATCH()
+    return NULL;
+}
+
 PyObject *P4PValue_id(PyObject *self)
 {
     TRY {
@@ -730,7 +1056,7 @@ PyObject *P4PValue_gettype(PyObject *self, PyObject *args)
         if(!name) {
             T = SELF.V->getStructure();
         } else {
-            pvd::PVFieldPtr F(SELF.V->getSubField(name));
+            pvd::PVField *F = SELF.lookup(name);
             if(!F)
                 return PyErr_Format(PyExc_KeyError, "No field %s", name);
             pvd::FieldConstPtr FT(F->getField());
@@ -756,11 +1082,11 @@ PyObject* P4PValue_changed(PyObject *self, PyObject *args, PyObject *kws)
         if(!SELF.I)
             Py_RETURN_TRUE;
 
-        pvd::PVField::shared_pointer fld;
+        pvd::PVField *fld;
         if(fname)
-            fld = SELF.V->getSubField(fname);
+            fld = SELF.lookup(fname);
         else
-            fld = SELF.V;
+            fld = SELF.V.get();
         if(!fld)
             return PyErr_Format(PyExc_KeyError, "%s", fname);
 
@@ -778,6 +1104,45 @@ PyObject* P4PValue_changed(PyObject *self, PyObject *args, PyObject *kws)
     return NULL;
 }
 
+PyObject* P4PValue_overrun(PyObject *self, PyObject *args, PyObject *kws)
+{
+    static const char* names[] = {"field", NULL};
+    const char* fname = NULL;
+    if(!PyArg_ParseTupleAndKeywords(args, kws, "|z", (char**)names, &fname))
+        return NULL;
+    TRY {
+
+        pvd::PVField *fld;
+        if(fname)
+            fld = SELF.lookup(fname);
+        else
+            fld = SELF.V.get();
+        if(!fld)
+            return PyErr_Format(PyExc_KeyError, "%s", fname);
+
+        if(!SELF.O)
+            Py_RETURN_FALSE;
+
+        if(!fname) {
+            // any field of this (sub-)structure
+            epicsInt32 next = SELF.O->nextSetBit(fld->getFieldOffset());
+            if(next>=0 && size_t(next)<fld->getNextFieldOffset())
+                Py_RETURN_TRUE;
+        } else if(SELF.O->get(fld->getFieldOffset())) {
+            Py_RETURN_TRUE;
+        }
+
+        for(pvd::PVStructure *parent = fld->getParent(); parent; parent = parent->getParent())
+        {
+            if(SELF.O->get(parent->getFieldOffset()))
+                Py_RETURN_TRUE;
+        }
+
+        Py_RETURN_FALSE;
+    }CATCH()
+    return NULL;
+}
+
 PyObject* P4PValue_mark(PyObject *self, PyObject *args, PyObject *kws)
 {
     static const char* names[] = {"field", "val", NULL};
@@ -789,11 +1154,11 @@ PyObject* P4PValue_mark(PyObject *self, PyObject *args, PyObject *kws)
         bool B = PyObject_IsTrue(val);
 
         if(SELF.I) {
-            pvd::PVField::shared_pointer fld;
+            pvd::PVField *fld;
             if(fname)
-                fld = SELF.V->getSubField(fname);
+                fld = SELF.lookup(fname);
             else
-                fld = SELF.V;
+                fld = SELF.V.get();
             if(!fld)
                 return PyErr_Format(PyExc_KeyError, "%s", fname);
 
@@ -855,13 +1220,13 @@ int P4PValue_setitem(PyObject *self, PyObject *name, PyObject *value)
 {
     TRY {
         PyString S(name);
-        pvd::PVFieldPtr fld = SELF.V->getSubField(S.str());
+        pvd::PVField *fld = SELF.lookup(S.str());
         if(!fld) {
             PyErr_SetString(PyExc_KeyError, S.str().c_str());
             return -1;
         }
 
-        SELF.storefld(fld.get(),
+        SELF.storefld(fld,
                        fld->getField().get(),
                        value,
                        SELF.I);
@@ -876,14 +1241,14 @@ PyObject* P4PValue_getitem(PyObject *self, PyObject *name)
 {
     TRY {
         PyString S(name);
-        pvd::PVFieldPtr fld = SELF.V->getSubField(S.str());
+        pvd::PVField *fld = SELF.lookup(S.str());
         if(!fld) {
             PyErr_SetString(PyExc_KeyError, S.str().c_str());
             return NULL;
         }
 
         // return sub-struct as Value
-        return SELF.fetchfld(fld.get(),
+        return SELF.fetchfld(fld,
                              fld->getField().get(),
                              SELF.I,
                              false);
@@ -891,6 +1256,59 @@ PyObject* P4PValue_getitem(PyObject *self, PyObject *name)
     return NULL;
 }
 
+PyObject* P4PValue_internStats(PyObject *junk)
+{
+    try {
+        return Py_BuildValue("{sKsKsKsKsKsKsKsKsKsK}",
+                             "strings", (unsigned long long)intern->strings.size(),
+                             "arrays", (unsigned long long)intern->arrays.size(),
+                             "bytes", (unsigned long long)intern->bytes(),
+                             "maxBytes", (unsigned long long)intern->maxBytes,
+                             "strHit", (unsigned long long)intern->nStrHit,
+                             "strMiss", (unsigned long long)intern->nStrMiss,
+                             "arrHit", (unsigned long long)intern->nArrHit,
+                             "arrMiss", (unsigned long long)intern->nArrMiss,
+                             "flush", (unsigned long long)intern->nFlush,
+                             "evict", (unsigned long long)(intern->strings.nEvict + intern->arrays.nEvict));
+    }CATCH()
+    return NULL;
+}
+
+PyObject* P4PValue_internConfig(PyObject *junk, PyObject *args, PyObject *kws)
+{
+    try {
+        static const char* names[] = {"maxBytes", "maxLength", NULL};
+        PyObject *maxB = Py_None, *maxL = Py_None;
+        if(!PyArg_ParseTupleAndKeywords(args, kws, "|OO", (char**)names, &maxB, &maxL))
+            return NULL;
+
+        Py_ssize_t nbytes = 0, nlen = 0;
+        if(maxB!=Py_None) {
+            nbytes = PyNumber_AsSsize_t(maxB, PyExc_OverflowError);
+            if(nbytes==-1 && PyErr_Occurred())
+                return NULL;
+        }
+        if(maxL!=Py_None) {
+            nlen = PyNumber_AsSsize_t(maxL, PyExc_OverflowError);
+            if(nlen==-1 && PyErr_Occurred())
+                return NULL;
+        }
+        if(nbytes<0 || nlen<0) {
+            PyErr_SetString(PyExc_ValueError, "Limits must not be negative");
+            return NULL;
+        }
+
+        if(maxB!=Py_None)
+            intern->maxBytes = nbytes;
+        if(maxL!=Py_None)
+            intern->maxLength = nlen;
+        intern->flush();
+
+        Py_RETURN_NONE;
+    }CATCH()
+    return NULL;
+}
+
 PyMappingMethods P4PValue_mapping = {
     (lenfunc)&P4PValue_len,
     (binaryfunc)&P4PValue_getitem,
@@ -910,6 +1328,11 @@ static PyMethodDef P4PValue_methods[] = {
     {"get", (PyCFunction)&P4PValue_get, METH_VARARGS,
      "get(\"fld\", [default])\n"
      "Fetch a field value, or a default if it does not exist"},
+    {"getarray", (PyCFunction)&P4PValue_getarray, METH_VARARGS|METH_KEYWORDS,
+     "getarray(\"fld\", dtype=None)\n\n"
+     "Fetch a numeric array field as a numpy array of the given dtype.\n"
+     "Conversion is done directly from the underlying array.  No copy is made\n"
+     "if dtype matches the field type, or is None."},
     {"getID", (PyCFunction)&P4PValue_id, METH_NOARGS,
      "getID()\n"
      "Return Structure ID string"},
@@ -928,6 +1351,20 @@ static PyMethodDef P4PValue_methods[] = {
     {"asSet", (PyCFunction)&P4PValue_asSet, METH_NOARGS,
      "asSet() -> set(['...'])\n\n"
      "set all changed fields"},
+    {"overrun", (PyCFunction)&P4PValue_overrun, METH_VARARGS|METH_KEYWORDS,
+     "overrun(field=None) -> bool\n\n"
+     "Test if the server squashed intermediate changes to a field of this monitor update.\n"
+     "With no field, test if any field was overrun.  Always False for Values\n"
+     "not received through a Subscription."},
+    // string cache
+    {"internStats", (PyCFunction)&P4PValue_internStats, METH_NOARGS|METH_STATIC,
+     "internStats() -> {'strings':0, ...}\n\n"
+     "Statistics of the cache of strings returned for string fields."},
+    {"internConfig", (PyCFunction)&P4PValue_internConfig, METH_VARARGS|METH_KEYWORDS|METH_STATIC,
+     "internConfig(maxBytes=None, maxLength=None)\n\n"
+     "Change limits of, and flush, the string cache.\n"
+     "The least recently used strings, and string arrays, are dropped to keep each within maxBytes.\n"
+     "Strings longer than maxLength are not cached."},
     {NULL}
 };
 
@@ -938,12 +1375,14 @@ PyTypeObject P4PValue::type = {
     sizeof(P4PValue),
 };
 
-const char value_doc[] =     "Value(type, value=None)\n"
+const char value_doc[] =     "Value(type, value=None, compare=False)\n"
         "\n"
         "Structured value container. Supports dict-list and object-list access\n"
         "\n"
         ":param Type type: A :py:class:`Type` describing the structure\n"
         ":param dict value: Initial values to populate the Value\n"
+        ":param bool compare: If True, assigning a scalar or array field with its current value\n"
+        "                     leaves it unchanged, and not marked as changed.\n"
         ;
 
 
@@ -966,6 +1405,9 @@ void p4p_value_register(PyObject *mod)
 
     P4PValue::type.tp_methods = P4PValue_methods;
 
+    if(!intern)
+        intern = new InternCache;
+
     if(PyType_Ready(&P4PValue::type))
         throw std::runtime_error("failed to initialize P4PValue_type");
 
@@ -990,9 +1432,48 @@ std::tr1::shared_ptr<epics::pvData::BitSet> P4PValue_unwrap_bitset(PyObject *obj
     return P4PValue::unwrap(obj).I;
 }
 
+void P4PValue_set_overrun(PyObject *value, const epics::pvData::BitSet::shared_pointer& O)
+{
+    if(!PyObject_TypeCheck(value, &P4PValue::type))
+        throw std::runtime_error("Not a _p4p.Value");
+    P4PValue::unwrap(value).O = O;
+}
+
+PyObject *P4PValue_ndarray(const array_type& arr)
+{
+    pvd::ScalarType etype(arr.original_type());
+    NPY_TYPES npy(ntype(etype));
+
+    size_t esize = pvd::ScalarTypeFunc::elementSize(etype);
+    npy_intp dim = arr.size()/esize;
+
+    PyRef pyarr(PyArray_New(&PyArray_Type, 1, &dim, npy, NULL, (void*)arr.data(),
+                            esize, NPY_CARRAY_RO, NULL));
+
+    PyObject *base = P4PArray_make(arr);
+    ((PyArrayObject*)pyarr.get())->base = base;
+
+    return pyarr.release();
+}
+
+PyObject *P4PValue_fetch(PyObject *value, epics::pvData::PVField *fld)
+{
+    if(!PyObject_TypeCheck(value, &P4PValue::type))
+        throw std::runtime_error("Not a _p4p.Value");
+    return P4PValue::unwrap(value).fetchfld(fld, fld->getField().get(), P4PValue::unwrap(value).I, false);
+}
+
+epics::pvData::PVField *P4PValue_lookup(PyObject *value, const std::string& name)
+{
+    if(!PyObject_TypeCheck(value, &P4PValue::type))
+        throw std::runtime_error("Not a _p4p.Value");
+    return P4PValue::unwrap(value).lookup(name);
+}
+
 PyObject *P4PValue_wrap(PyTypeObject *type,
                         const epics::pvData::PVStructure::shared_pointer& V,
-                        const epics::pvData::BitSet::shared_pointer & I)
+                        const epics::pvData::BitSet::shared_pointer & I,
+                        const std::tr1::shared_ptr<void>& holder)
 {
     assert(V.get());
     if(!PyType_IsSubtype(type, &P4PValue::type))
@@ -1010,6 +1491,7 @@ PyObject *P4PValue_wrap(PyTypeObject *type,
         Value& val = P4PValue::unwrap(ret.get());
         val.V = V;
         val.I = I;
+        val.holder = holder;
     }
 
     if(type->tp_init(ret.get(), args.get(), kws.get()))